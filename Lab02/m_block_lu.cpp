@@ -0,0 +1,138 @@
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include "m_block_lu.h"
+
+const size_t m_block_lu::BLOCK_SIZE = 64;
+
+m_block_lu::m_block_lu(const m_matrix &stripe, const size_t first_row, const size_t rows) : size(rows),
+                                                                                            factors(rows * rows),
+                                                                                            permutation(rows)
+{
+	for (size_t i = 0; i < this->size; ++i)
+	{
+		auto &row = stripe[i];
+		for (size_t j = 0; j < this->size; ++j)
+		{
+			this->factors[i * this->size + j] = row[first_row + j];
+		}
+		this->permutation[i] = i;
+	}
+
+	for (size_t first = 0; first < this->size; first += BLOCK_SIZE)
+	{
+		auto last = std::min(first + BLOCK_SIZE, this->size);
+		this->factor_panel(first, last);
+		this->update_trailing(first, last);
+	}
+}
+
+void m_block_lu::factor_panel(const size_t first, const size_t last)
+{
+	auto n = this->size;
+	auto a = this->factors.data();
+
+	for (auto k = first; k < last; ++k)
+	{
+		auto pivot = k;
+		for (auto i = k + 1; i < n; ++i)
+		{
+			if (std::fabs(a[i * n + k]) > std::fabs(a[pivot * n + k]))
+			{
+				pivot = i;
+			}
+		}
+
+		if (a[pivot * n + k] == 0)
+		{
+			std::stringstream ss;
+			ss << "Can't factor the diagonal block, it is singular at column " << k << "!";
+			throw std::runtime_error(ss.str());
+		}
+
+		// Whole rows are swapped, so the already computed L part follows its row
+		if (pivot != k)
+		{
+			std::swap_ranges(a + k * n, a + (k + 1) * n, a + pivot * n);
+			std::swap(this->permutation[k], this->permutation[pivot]);
+		}
+
+		// Elimination stays inside the panel columns, the rest is left to the trailing update
+		for (auto i = k + 1; i < n; ++i)
+		{
+			auto factor = a[i * n + k] /= a[k * n + k];
+			for (auto j = k + 1; j < last; ++j)
+			{
+				a[i * n + j] -= factor * a[k * n + j];
+			}
+		}
+	}
+}
+
+void m_block_lu::update_trailing(const size_t first, const size_t last)
+{
+	auto n = this->size;
+	auto a = this->factors.data();
+
+	// U12 = L11^-1 * A12
+	for (auto k = first; k < last; ++k)
+	{
+		for (auto i = k + 1; i < last; ++i)
+		{
+			auto factor = a[i * n + k];
+			for (auto j = last; j < n; ++j)
+			{
+				a[i * n + j] -= factor * a[k * n + j];
+			}
+		}
+	}
+
+	// A22 -= L21 * U12, tile by tile of the trailing columns
+	for (auto column_tile = last; column_tile < n; column_tile += BLOCK_SIZE)
+	{
+		auto column_end = std::min(column_tile + BLOCK_SIZE, n);
+		for (auto i = last; i < n; ++i)
+		{
+			auto row = a + i * n;
+			for (auto k = first; k < last; ++k)
+			{
+				auto factor = row[k];
+				auto source = a + k * n;
+				for (auto j = column_tile; j < column_end; ++j)
+				{
+					row[j] -= factor * source[j];
+				}
+			}
+		}
+	}
+}
+
+void m_block_lu::solve(std::vector<type_t> &values) const
+{
+	auto n = this->size;
+	auto a = this->factors.data();
+	std::vector<type_t> result(n);
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		auto sum = values[this->permutation[i]];
+		for (size_t j = 0; j < i; ++j)
+		{
+			sum -= a[i * n + j] * result[j];
+		}
+		result[i] = sum;
+	}
+
+	for (auto i = n; i-- > 0;)
+	{
+		auto sum = result[i];
+		for (auto j = i + 1; j < n; ++j)
+		{
+			sum -= a[i * n + j] * result[j];
+		}
+		result[i] = sum / a[i * n + i];
+	}
+
+	std::copy(result.begin(), result.end(), values.begin());
+}
@@ -0,0 +1,32 @@
+#ifndef LAB02_BLOCK_LU_H
+#define LAB02_BLOCK_LU_H
+
+#include <vector>
+#include "m_matrix.h"
+
+// LU factors with partial pivoting of the square diagonal block of a row stripe: its first
+// rows rows and columns [first_row, first_row + rows). The factorization is right-looking
+// and works on tiles of BLOCK_SIZE columns so that the trailing update stays in cache.
+class m_block_lu
+{
+	static const size_t BLOCK_SIZE;
+
+	const size_t size;
+	// Row-major, unit lower L below the diagonal and U on and above it
+	std::vector<type_t> factors;
+	std::vector<size_t> permutation;
+
+	void factor_panel(const size_t first, const size_t last);
+	void update_trailing(const size_t first, const size_t last);
+public:
+	m_block_lu(const m_matrix &stripe, const size_t first_row, const size_t rows);
+	// Overwrites the right-hand side with the solution of the block system
+	void solve(std::vector<type_t> &values) const;
+
+	size_t get_size() const
+	{
+		return size;
+	}
+};
+
+#endif //LAB02_BLOCK_LU_H
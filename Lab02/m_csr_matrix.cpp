@@ -0,0 +1,71 @@
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include "m_csr_matrix.h"
+
+m_csr_matrix::m_csr_matrix(const size_t rows) : rows(rows)
+{
+	this->row_starts.reserve(rows + 1);
+	this->row_starts.push_back(0);
+}
+
+m_csr_matrix::matrix_t m_csr_matrix::from_triplets(const size_t rows, const size_t first_row,
+                                                   const std::vector<unsigned long long> &row_indices,
+                                                   const std::vector<unsigned long long> &column_indices,
+                                                   const std::vector<type_t> &values)
+{
+	std::vector<size_t> order(values.size());
+	std::iota(order.begin(), order.end(), static_cast<size_t>(0));
+	std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b)
+	          {
+		          return row_indices[a] != row_indices[b]
+			                 ? row_indices[a] < row_indices[b]
+			                 : column_indices[a] < column_indices[b];
+	          });
+
+	auto result = std::make_shared<m_csr_matrix>(rows);
+	size_t row = 0;
+
+	for (auto k : order)
+	{
+		if (row_indices[k] < first_row || row_indices[k] >= first_row + rows)
+		{
+			std::stringstream ss;
+			ss << "Row " << row_indices[k] << " does not belong to the stripe ["
+				<< first_row << ", " << first_row + rows << ")!";
+			throw std::range_error(ss.str());
+		}
+
+		while (first_row + row < row_indices[k])
+		{
+			result->next_row();
+			row++;
+		}
+		result->push(column_indices[k], values[k]);
+	}
+
+	while (row < rows)
+	{
+		result->next_row();
+		row++;
+	}
+
+	return result;
+}
+
+void m_csr_matrix::push(const size_t column, const type_t value)
+{
+	this->columns.push_back(column);
+	this->values.push_back(value);
+}
+
+void m_csr_matrix::next_row()
+{
+	if (this->row_starts.size() > this->rows)
+	{
+		throw std::range_error("Can't add more rows than the matrix stripe holds!");
+	}
+
+	this->row_starts.push_back(this->values.size());
+}
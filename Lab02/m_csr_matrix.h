@@ -0,0 +1,57 @@
+#ifndef LAB02_CSR_MATRIX_H
+#define LAB02_CSR_MATRIX_H
+
+#include <vector>
+#include <memory>
+#include "m_vector.h"
+
+// Stripe of a sparse matrix in compressed sparse row form, filled row by row.
+// Column indices are global until a halo pattern renumbers them into the local space.
+class m_csr_matrix
+{
+	const size_t rows;
+	std::vector<size_t> row_starts;
+	std::vector<size_t> columns;
+	std::vector<type_t> values;
+public:
+	typedef std::shared_ptr<m_csr_matrix> matrix_t;
+	explicit m_csr_matrix(const size_t rows);
+	static matrix_t from_triplets(const size_t rows, const size_t first_row,
+	                              const std::vector<unsigned long long> &row_indices,
+	                              const std::vector<unsigned long long> &column_indices,
+	                              const std::vector<type_t> &values);
+	void push(const size_t column, const type_t value);
+	void next_row();
+
+	size_t get_rows() const
+	{
+		return rows;
+	}
+
+	size_t get_nonzeros() const
+	{
+		return values.size();
+	}
+
+	const std::vector<size_t> &get_row_starts() const
+	{
+		return row_starts;
+	}
+
+	std::vector<size_t> &get_columns()
+	{
+		return columns;
+	}
+
+	const std::vector<size_t> &get_columns() const
+	{
+		return columns;
+	}
+
+	const std::vector<type_t> &get_values() const
+	{
+		return values;
+	}
+};
+
+#endif //LAB02_CSR_MATRIX_H
@@ -0,0 +1,186 @@
+#include <stdexcept>
+#include <algorithm>
+#include "m_generator.h"
+
+const std::string m_generator::TRIANGULAR_FAMILY = "triangular";
+const std::string m_generator::DOMINANT_FAMILY = "dominant";
+const std::string m_generator::BANDED_FAMILY = "banded";
+
+namespace
+{
+	// SplitMix64 finalizer: a stateless mapping of (seed, row, column) to a uniform 64-bit value
+	unsigned long long mix(unsigned long long x)
+	{
+		x += 0x9E3779B97F4A7C15ULL;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+}
+
+m_generator::m_generator(const size_t size) : size(size)
+{
+}
+
+m_generator::generator_t m_generator::create(const std::string &family, const size_t size,
+                                             const size_t bandwidth, const unsigned long long seed)
+{
+	if (family == TRIANGULAR_FAMILY)
+	{
+		return std::make_shared<m_triangular_generator>(size);
+	}
+	if (family == DOMINANT_FAMILY)
+	{
+		return std::make_shared<m_dominant_generator>(size, seed);
+	}
+	if (family == BANDED_FAMILY)
+	{
+		return std::make_shared<m_banded_generator>(size, bandwidth);
+	}
+
+	throw std::invalid_argument("Unknown matrix family: " + family + "! Expected one of: "
+		+ TRIANGULAR_FAMILY + ", " + DOMINANT_FAMILY + ", " + BANDED_FAMILY);
+}
+
+std::pair<size_t, size_t> m_generator::column_range(const size_t /*row*/) const
+{
+	return std::make_pair(static_cast<size_t>(0), this->size);
+}
+
+m_matrix::matrix_t m_generator::generate_rows(const size_t first_row, const size_t rows) const
+{
+	auto result = std::make_shared<m_matrix>(rows, this->size);
+
+	for (size_t i = 0; i < rows; ++i)
+	{
+		auto range = this->column_range(first_row + i);
+		for (auto j = range.first; j < range.second; ++j)
+		{
+			(*result)[i][j] = this->coefficient(first_row + i, j);
+		}
+	}
+
+	return result;
+}
+
+m_csr_matrix::matrix_t m_generator::generate_sparse_rows(const size_t first_row, const size_t rows) const
+{
+	auto result = std::make_shared<m_csr_matrix>(rows);
+
+	for (size_t i = 0; i < rows; ++i)
+	{
+		auto range = this->column_range(first_row + i);
+		for (auto j = range.first; j < range.second; ++j)
+		{
+			auto value = this->coefficient(first_row + i, j);
+			if (value != 0)
+			{
+				result->push(j, value);
+			}
+		}
+		result->next_row();
+	}
+
+	return result;
+}
+
+m_vector::vector_t m_generator::generate_right_hand(const size_t first_row, const size_t rows) const
+{
+	auto result = std::make_shared<m_vector>(rows);
+
+	for (size_t i = 0; i < rows; ++i)
+	{
+		(*result)[i] = this->right_hand(first_row + i);
+	}
+
+	return result;
+}
+
+m_triangular_generator::m_triangular_generator(const size_t size) : m_generator(size)
+{
+}
+
+type_t m_triangular_generator::coefficient(const size_t row, const size_t column) const
+{
+	if (row == column)
+	{
+		return static_cast<type_t>(1);
+	}
+
+	return static_cast<type_t>(row < column ? -2 : 0);
+}
+
+type_t m_triangular_generator::right_hand(const size_t row) const
+{
+	return static_cast<type_t>(row % 2 ? -1.0 / 3.0 : 1);
+}
+
+std::pair<size_t, size_t> m_triangular_generator::column_range(const size_t row) const
+{
+	return std::make_pair(std::min(row, this->size), this->size);
+}
+
+m_dominant_generator::m_dominant_generator(const size_t size, const unsigned long long seed) : m_generator(size),
+                                                                                              seed(seed)
+{
+}
+
+type_t m_dominant_generator::coefficient(const size_t row, const size_t column) const
+{
+	if (row == column)
+	{
+		// Every off-diagonal value is at most 1 by absolute value
+		return static_cast<type_t>(this->size);
+	}
+
+	auto bits = mix(mix(this->seed ^ row) ^ column) >> 11;
+	return static_cast<type_t>(2.0 * static_cast<double>(bits) / static_cast<double>(1ULL << 53) - 1.0);
+}
+
+type_t m_dominant_generator::right_hand(const size_t row) const
+{
+	type_t sum = 0;
+
+	for (size_t j = 0; j < this->size; ++j)
+	{
+		sum += this->coefficient(row, j);
+	}
+
+	return sum;
+}
+
+m_banded_generator::m_banded_generator(const size_t size, const size_t bandwidth) : m_generator(size),
+                                                                                    bandwidth(bandwidth)
+{
+}
+
+type_t m_banded_generator::coefficient(const size_t row, const size_t column) const
+{
+	if (row == column)
+	{
+		return static_cast<type_t>(2 * this->bandwidth + 1);
+	}
+
+	auto offset = row < column ? column - row : row - column;
+	return static_cast<type_t>(offset <= this->bandwidth ? -1 : 0);
+}
+
+type_t m_banded_generator::right_hand(const size_t row) const
+{
+	auto range = this->column_range(row);
+	type_t sum = 0;
+
+	for (auto j = range.first; j < range.second; ++j)
+	{
+		sum += this->coefficient(row, j);
+	}
+
+	return sum;
+}
+
+std::pair<size_t, size_t> m_banded_generator::column_range(const size_t row) const
+{
+	auto first = row > this->bandwidth ? row - this->bandwidth : 0;
+	auto last = std::min(row + this->bandwidth + 1, this->size);
+	return std::make_pair(first, last);
+}
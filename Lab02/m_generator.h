@@ -0,0 +1,76 @@
+#ifndef LAB02_GENERATOR_H
+#define LAB02_GENERATOR_H
+
+#include <string>
+#include <memory>
+#include "m_matrix.h"
+#include "m_csr_matrix.h"
+
+// Closed-form source of a synthetic n x n system. Every coefficient is a pure function
+// of its global position, so each process can build only its own stripe of rows.
+class m_generator
+{
+protected:
+	const size_t size;
+public:
+	typedef std::shared_ptr<m_generator> generator_t;
+
+	static const std::string TRIANGULAR_FAMILY;
+	static const std::string DOMINANT_FAMILY;
+	static const std::string BANDED_FAMILY;
+
+	explicit m_generator(const size_t size);
+	virtual ~m_generator() = default;
+
+	static generator_t create(const std::string &family, const size_t size,
+	                          const size_t bandwidth, const unsigned long long seed);
+
+	virtual type_t coefficient(const size_t row, const size_t column) const = 0;
+	virtual type_t right_hand(const size_t row) const = 0;
+	// Half-open range of columns that may hold non-zero coefficients in the row
+	virtual std::pair<size_t, size_t> column_range(const size_t row) const;
+
+	m_matrix::matrix_t generate_rows(const size_t first_row, const size_t rows) const;
+	m_csr_matrix::matrix_t generate_sparse_rows(const size_t first_row, const size_t rows) const;
+	m_vector::vector_t generate_right_hand(const size_t first_row, const size_t rows) const;
+
+	size_t get_size() const
+	{
+		return size;
+	}
+};
+
+// The pattern of m_matrix::generate_matrix and m_vector::generate_vector
+class m_triangular_generator : public m_generator
+{
+public:
+	explicit m_triangular_generator(const size_t size);
+	type_t coefficient(const size_t row, const size_t column) const override;
+	type_t right_hand(const size_t row) const override;
+	std::pair<size_t, size_t> column_range(const size_t row) const override;
+};
+
+// Dense random off-diagonal values in [-1, 1] with a strictly dominant diagonal.
+// The right-hand side is the row sum, so the exact solution is a vector of ones.
+class m_dominant_generator : public m_generator
+{
+	const unsigned long long seed;
+public:
+	m_dominant_generator(const size_t size, const unsigned long long seed);
+	type_t coefficient(const size_t row, const size_t column) const override;
+	type_t right_hand(const size_t row) const override;
+};
+
+// -1 on the diagonals within the bandwidth and 2 * bandwidth + 1 on the main one.
+// The right-hand side is the row sum, so the exact solution is a vector of ones.
+class m_banded_generator : public m_generator
+{
+	const size_t bandwidth;
+public:
+	m_banded_generator(const size_t size, const size_t bandwidth);
+	type_t coefficient(const size_t row, const size_t column) const override;
+	type_t right_hand(const size_t row) const override;
+	std::pair<size_t, size_t> column_range(const size_t row) const override;
+};
+
+#endif //LAB02_GENERATOR_H
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include "m_halo.h"
+
+m_halo::m_halo(m_csr_matrix &matrix, const size_t first_row,
+               const std::vector<int> &rows_positions, const MPI_Comm comm):
+	comm(comm),
+	rows(matrix.get_rows()),
+	halo_size(0)
+{
+	int total_processes;
+	MPI_Comm_size(comm, &total_processes);
+
+	auto &columns = matrix.get_columns();
+	auto last_row = first_row + this->rows;
+
+	// Distinct remote columns in ascending order are already grouped by owner
+	std::vector<unsigned long long> halo_columns;
+	for (auto column : columns)
+	{
+		if (column < first_row || column >= last_row)
+		{
+			halo_columns.push_back(column);
+		}
+	}
+	std::sort(halo_columns.begin(), halo_columns.end());
+	halo_columns.erase(std::unique(halo_columns.begin(), halo_columns.end()), halo_columns.end());
+	this->halo_size = halo_columns.size();
+
+	std::vector<int> need_counts(total_processes, 0);
+	std::vector<int> need_displs(total_processes, 0);
+	for (auto column : halo_columns)
+	{
+		// The last process starting at or before the column owns it; empty ones start where the next one does
+		auto owner = std::upper_bound(rows_positions.begin(), rows_positions.end(), static_cast<int>(column))
+			- rows_positions.begin() - 1;
+		need_counts[owner]++;
+	}
+	for (auto p = 1; p < total_processes; ++p)
+	{
+		need_displs[p] = need_displs[p - 1] + need_counts[p - 1];
+	}
+
+	for (auto &column : columns)
+	{
+		column = column >= first_row && column < last_row
+			         ? column - first_row
+			         : this->rows + (std::lower_bound(halo_columns.begin(), halo_columns.end(), column) - halo_columns.begin());
+	}
+
+	// Tell every owner which of its entries are needed, once
+	std::vector<int> give_counts(total_processes, 0);
+	std::vector<int> give_displs(total_processes, 0);
+	MPI_Alltoall(need_counts.data(), 1, MPI_INT, give_counts.data(), 1, MPI_INT, comm);
+	for (auto p = 1; p < total_processes; ++p)
+	{
+		give_displs[p] = give_displs[p - 1] + give_counts[p - 1];
+	}
+
+	std::vector<unsigned long long> requested(give_displs[total_processes - 1] + give_counts[total_processes - 1]);
+	MPI_Alltoallv(halo_columns.data(), need_counts.data(), need_displs.data(), MPI_UNSIGNED_LONG_LONG,
+	              requested.data(), give_counts.data(), give_displs.data(), MPI_UNSIGNED_LONG_LONG, comm);
+
+	for (auto column : requested)
+	{
+		this->send_indices.push_back(static_cast<size_t>(column - first_row));
+	}
+
+	for (auto p = 0; p < total_processes; ++p)
+	{
+		if (give_counts[p] > 0)
+		{
+			this->send_ranks.push_back(p);
+			this->send_counts.push_back(give_counts[p]);
+		}
+		if (need_counts[p] > 0)
+		{
+			this->recv_ranks.push_back(p);
+			this->recv_counts.push_back(need_counts[p]);
+		}
+	}
+
+	this->send_buffer.resize(this->send_indices.size());
+	this->requests.resize(this->send_ranks.size() + this->recv_ranks.size());
+}
+
+void m_halo::exchange(std::vector<type_t> &x)
+{
+	auto request = 0;
+	auto offset = this->rows;
+
+	for (size_t k = 0; k < this->recv_ranks.size(); ++k)
+	{
+		MPI_Irecv(x.data() + offset, this->recv_counts[k], mpi_type_t,
+		          this->recv_ranks[k], 0, this->comm, &this->requests[request++]);
+		offset += this->recv_counts[k];
+	}
+
+	for (size_t k = 0; k < this->send_indices.size(); ++k)
+	{
+		this->send_buffer[k] = x[this->send_indices[k]];
+	}
+
+	offset = 0;
+	for (size_t k = 0; k < this->send_ranks.size(); ++k)
+	{
+		MPI_Isend(this->send_buffer.data() + offset, this->send_counts[k], mpi_type_t,
+		          this->send_ranks[k], 0, this->comm, &this->requests[request++]);
+		offset += this->send_counts[k];
+	}
+
+	MPI_Waitall(request, this->requests.data(), MPI_STATUSES_IGNORE);
+}
@@ -0,0 +1,50 @@
+#ifndef LAB02_HALO_H
+#define LAB02_HALO_H
+
+#include <mpi.h>
+#include <vector>
+#include "m_csr_matrix.h"
+
+// Exchange pattern for the entries of x that a row stripe references outside its own rows.
+// Building it renumbers the matrix columns: [0, rows) are own entries and
+// [rows, rows + halo size) are received ones, grouped by owner.
+class m_halo
+{
+	const MPI_Comm comm;
+	size_t rows;
+	size_t halo_size;
+	std::vector<int> send_ranks;
+	std::vector<int> send_counts;
+	std::vector<size_t> send_indices;
+	std::vector<int> recv_ranks;
+	std::vector<int> recv_counts;
+	std::vector<type_t> send_buffer;
+	std::vector<MPI_Request> requests;
+public:
+	m_halo(m_csr_matrix &matrix, const size_t first_row,
+	       const std::vector<int> &rows_positions, const MPI_Comm comm);
+	// x holds own entries first; the halo part behind them is overwritten with the owners' values
+	void exchange(std::vector<type_t> &x);
+
+	size_t get_halo_size() const
+	{
+		return halo_size;
+	}
+
+	size_t get_send_size() const
+	{
+		return send_indices.size();
+	}
+
+	size_t get_recv_neighbours() const
+	{
+		return recv_ranks.size();
+	}
+
+	size_t get_send_neighbours() const
+	{
+		return send_ranks.size();
+	}
+};
+
+#endif //LAB02_HALO_H
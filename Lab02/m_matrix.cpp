@@ -32,6 +32,32 @@ std::pair<m_matrix::matrix_t, m_vector::vector_t> m_matrix::split() const
 	return make_pair(a, b);
 }
 
+std::pair<m_matrix::matrix_t, m_matrix::matrix_t> m_matrix::split(const size_t right_hand_columns) const
+{
+	if (right_hand_columns == 0 || this->get_columns() <= right_hand_columns)
+	{
+		throw std::range_error("Can't extract the right-hand columns from matrix with too few columns!");
+	}
+
+	auto columns = this->get_columns() - right_hand_columns;
+	auto a = std::make_shared<m_matrix>(this->get_rows(), columns);
+	auto b = std::make_shared<m_matrix>(this->get_rows(), right_hand_columns);
+
+	for (size_t i = 0; i < this->get_rows(); ++i)
+	{
+		for (size_t j = 0; j < columns; ++j)
+		{
+			(*a)[i][j] = (*(*this->data)[i])[j];
+		}
+		for (size_t j = 0; j < right_hand_columns; ++j)
+		{
+			(*b)[i][j] = (*(*this->data)[i])[columns + j];
+		}
+	}
+
+	return make_pair(a, b);
+}
+
 
 std::shared_ptr<std::vector<type_t>> m_matrix::get_plain_data() const
 {
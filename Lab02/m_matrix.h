@@ -17,6 +17,8 @@ public:
 	explicit m_matrix(const size_t rows, const size_t columns);
 	static matrix_t generate_matrix(const size_t rows, const size_t columns);
 	std::pair<matrix_t, m_vector::vector_t> split() const;
+	// The last right_hand_columns columns form the second matrix
+	std::pair<matrix_t, matrix_t> split(const size_t right_hand_columns) const;
 	std::shared_ptr<std::vector<type_t>> get_plain_data() const;
 	void fill(std::shared_ptr<std::vector<type_t>> &plain_data, const size_t size) const;
 
@@ -72,4 +74,4 @@ public:
 	}
 };
 
-#endif LAB02_MATRIX_H
+#endif //LAB02_MATRIX_H
@@ -0,0 +1,49 @@
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include "m_process_grid.h"
+
+m_process_grid::m_process_grid(const size_t size, const size_t block, const MPI_Comm comm): size(size),
+                                                                                             block(block)
+{
+	int total_processes, process_id;
+	MPI_Comm_size(comm, &total_processes);
+	MPI_Comm_rank(comm, &process_id);
+
+	this->dimension = static_cast<int>(std::lround(std::sqrt(static_cast<double>(total_processes))));
+
+	if (this->dimension * this->dimension != total_processes)
+	{
+		std::stringstream ss;
+		ss << "2D process grid needs a square number of processes, got " << total_processes << "!";
+		throw std::invalid_argument(ss.str());
+	}
+
+	this->row = process_id / this->dimension;
+	this->column = process_id % this->dimension;
+
+	MPI_Comm_split(comm, this->row, this->column, &this->row_comm);
+	MPI_Comm_split(comm, this->column, this->row, &this->column_comm);
+}
+
+m_process_grid::~m_process_grid()
+{
+	MPI_Comm_free(&this->row_comm);
+	MPI_Comm_free(&this->column_comm);
+}
+
+std::vector<size_t> m_process_grid::indices(const int group) const
+{
+	std::vector<size_t> result;
+	auto stride = this->block * this->dimension;
+
+	for (auto first = group * this->block; first < this->size; first += stride)
+	{
+		for (auto i = first; i < first + this->block && i < this->size; ++i)
+		{
+			result.push_back(i);
+		}
+	}
+
+	return result;
+}
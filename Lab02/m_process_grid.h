@@ -0,0 +1,60 @@
+#ifndef LAB02_PROCESS_GRID_H
+#define LAB02_PROCESS_GRID_H
+
+#include <mpi.h>
+#include <vector>
+
+// Square q x q arrangement of the processes over an n x n matrix. Rows and columns are
+// dealt to the grid block-cyclically: index i belongs to group (i / block) % q.
+// Process (r, c) owns the block of matrix rows of group r and columns of group c.
+class m_process_grid
+{
+	const size_t size;
+	const size_t block;
+	int dimension;
+	int row;
+	int column;
+	MPI_Comm row_comm;
+	MPI_Comm column_comm;
+public:
+	m_process_grid(const size_t size, const size_t block, const MPI_Comm comm);
+	m_process_grid(const m_process_grid &) = delete;
+	m_process_grid &operator=(const m_process_grid &) = delete;
+	~m_process_grid();
+
+	std::vector<size_t> indices(const int group) const;
+
+	// Rank inside the communicator equals the column index of the process
+	MPI_Comm get_row_comm() const
+	{
+		return row_comm;
+	}
+
+	// Rank inside the communicator equals the row index of the process
+	MPI_Comm get_column_comm() const
+	{
+		return column_comm;
+	}
+
+	int get_dimension() const
+	{
+		return dimension;
+	}
+
+	int get_row() const
+	{
+		return row;
+	}
+
+	int get_column() const
+	{
+		return column;
+	}
+
+	bool is_diagonal() const
+	{
+		return row == column;
+	}
+};
+
+#endif //LAB02_PROCESS_GRID_H
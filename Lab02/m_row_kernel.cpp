@@ -0,0 +1,48 @@
+#include "m_row_kernel.h"
+
+m_row_kernel::m_row_kernel(const m_matrix &stripe, const m_vector &right_hand_side, const size_t first_row,
+                           const size_t rows):
+	rows(rows),
+	columns(stripe.get_columns()),
+	off_diagonal(rows * stripe.get_columns()),
+	inverse_diagonal(rows),
+	right_hand(rows)
+{
+	for (size_t i = 0; i < this->rows; ++i)
+	{
+		auto &row = stripe[i];
+		for (size_t j = 0; j < this->columns; ++j)
+		{
+			this->off_diagonal[i * this->columns + j] = static_cast<kernel_t>(row[j]);
+		}
+		this->inverse_diagonal[i] = 1 / static_cast<kernel_t>(row[first_row + i]);
+		this->off_diagonal[i * this->columns + first_row + i] = 0;
+		this->right_hand[i] = static_cast<kernel_t>(right_hand_side[i]);
+	}
+}
+
+void m_row_kernel::sweep(const kernel_t *x, kernel_t *result) const
+{
+	auto rows = static_cast<long long>(this->rows);
+	auto columns = this->columns;
+	auto matrix = this->off_diagonal.data();
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+	for (long long i = 0; i < rows; ++i)
+	{
+		auto row = matrix + i * columns;
+		kernel_t sum = 0;
+
+#ifdef _OPENMP
+#pragma omp simd reduction(+:sum)
+#endif
+		for (size_t j = 0; j < columns; ++j)
+		{
+			sum += row[j] * x[j];
+		}
+
+		result[i] = (this->right_hand[i] - sum) * this->inverse_diagonal[i];
+	}
+}
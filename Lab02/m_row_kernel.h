@@ -0,0 +1,35 @@
+#ifndef LAB02_ROW_KERNEL_H
+#define LAB02_ROW_KERNEL_H
+
+#include <vector>
+#include "m_matrix.h"
+
+// Jacobi row update over a local stripe of the system with the diagonal kept apart:
+// x_new[i] = (b[i] - sum_j off_diagonal[i][j] * x[j]) * inverse_diagonal[i].
+// Values are stored in double so that the inner product vectorises; long double has no SIMD form.
+class m_row_kernel
+{
+public:
+	typedef double kernel_t;
+private:
+	const size_t rows, columns;
+	std::vector<kernel_t> off_diagonal;
+	std::vector<kernel_t> inverse_diagonal;
+	std::vector<kernel_t> right_hand;
+public:
+	// Only the first rows of the stripe are taken: the root keeps the whole matrix after reading it
+	m_row_kernel(const m_matrix &stripe, const m_vector &right_hand_side, const size_t first_row, const size_t rows);
+	void sweep(const kernel_t *x, kernel_t *result) const;
+
+	kernel_t get_diagonal(const size_t row) const
+	{
+		return 1 / inverse_diagonal[row];
+	}
+
+	size_t get_rows() const
+	{
+		return rows;
+	}
+};
+
+#endif //LAB02_ROW_KERNEL_H
@@ -0,0 +1,104 @@
+#include <mpi.h>
+#include <stdexcept>
+#include <algorithm>
+#include "m_shared_window.h"
+
+m_shared_window::m_shared_window(const size_t size, const size_t buffers,
+                                 const size_t first_row, const size_t rows, const MPI_Comm comm):
+	size(size),
+	buffers(buffers),
+	leader_comm(MPI_COMM_NULL),
+	base(nullptr)
+{
+	int process_id;
+	MPI_Comm_rank(comm, &process_id);
+
+	MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, process_id, MPI_INFO_NULL, &this->node_comm);
+	MPI_Comm_rank(this->node_comm, &this->node_rank);
+	MPI_Comm_size(this->node_comm, &this->node_size);
+
+	long local[2] = {static_cast<long>(first_row), static_cast<long>(rows)};
+	std::vector<long> stripes(2 * this->node_size);
+	MPI_Allgather(local, 2, MPI_LONG, stripes.data(), 2, MPI_LONG, this->node_comm);
+
+	// The leader can send the node part as one piece only if it has no gaps
+	long node_first = static_cast<long>(size), node_last = 0, node_total = 0;
+	for (auto p = 0; p < this->node_size; ++p)
+	{
+		if (stripes[2 * p + 1] > 0)
+		{
+			node_first = std::min(node_first, stripes[2 * p]);
+			node_last = std::max(node_last, stripes[2 * p] + stripes[2 * p + 1]);
+			node_total += stripes[2 * p + 1];
+		}
+	}
+
+	auto contiguous = node_total == 0 || node_last - node_first == node_total ? 1 : 0;
+	auto all_contiguous = 0;
+	MPI_Allreduce(&contiguous, &all_contiguous, 1, MPI_INT, MPI_MIN, comm);
+
+	if (!all_contiguous)
+	{
+		MPI_Comm_free(&this->node_comm);
+		throw std::invalid_argument("Shared windows need the rows of the processes of one node to be contiguous!");
+	}
+
+	MPI_Comm_split(comm, this->node_rank == 0 ? 0 : MPI_UNDEFINED, process_id, &this->leader_comm);
+
+	if (this->node_rank == 0)
+	{
+		MPI_Comm_size(this->leader_comm, &this->nodes);
+
+		int node[2] = {static_cast<int>(node_total), static_cast<int>(node_total ? node_first : 0)};
+		std::vector<int> parts(2 * this->nodes);
+		MPI_Allgather(node, 2, MPI_INT, parts.data(), 2, MPI_INT, this->leader_comm);
+
+		for (auto p = 0; p < this->nodes; ++p)
+		{
+			this->node_rows.push_back(parts[2 * p]);
+			this->node_positions.push_back(parts[2 * p + 1]);
+		}
+	}
+
+	MPI_Bcast(&this->nodes, 1, MPI_INT, 0, this->node_comm);
+
+	// The leader allocates the whole node copy, the others attach to it
+	auto bytes = static_cast<MPI_Aint>(this->node_rank == 0 ? size * buffers * sizeof(type_t) : 0);
+	MPI_Win_allocate_shared(bytes, sizeof(type_t), MPI_INFO_NULL, this->node_comm, &this->base, &this->window);
+
+	MPI_Aint leader_bytes;
+	int unit;
+	MPI_Win_shared_query(this->window, 0, &leader_bytes, &unit, &this->base);
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, this->window);
+}
+
+m_shared_window::~m_shared_window()
+{
+	MPI_Win_unlock_all(this->window);
+	MPI_Win_free(&this->window);
+
+	if (this->leader_comm != MPI_COMM_NULL)
+	{
+		MPI_Comm_free(&this->leader_comm);
+	}
+	MPI_Comm_free(&this->node_comm);
+}
+
+void m_shared_window::exchange(const size_t buffer)
+{
+	// Own rows written by every process become visible to the leader
+	MPI_Win_sync(this->window);
+	MPI_Barrier(this->node_comm);
+
+	if (this->node_rank == 0 && this->nodes > 1)
+	{
+		MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+		               this->get_buffer(buffer), this->node_rows.data(), this->node_positions.data(), mpi_type_t,
+		               this->leader_comm);
+	}
+
+	// ... and the rows of the other nodes received by the leader become visible to everyone
+	MPI_Win_sync(this->window);
+	MPI_Barrier(this->node_comm);
+	MPI_Win_sync(this->window);
+}
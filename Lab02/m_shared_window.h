@@ -0,0 +1,55 @@
+#ifndef LAB02_SHARED_WINDOW_H
+#define LAB02_SHARED_WINDOW_H
+
+#include <mpi.h>
+#include <vector>
+#include "m_vector.h"
+
+// Full-length vectors kept once per node in an MPI-3 shared memory window.
+// Every process writes its own rows in place; only the node leaders exchange
+// the node parts with each other. The rows of the processes of one node must be contiguous.
+class m_shared_window
+{
+	const size_t size;
+	const size_t buffers;
+	MPI_Comm node_comm;
+	MPI_Comm leader_comm;
+	MPI_Win window;
+	type_t *base;
+	int node_rank;
+	int node_size;
+	int nodes;
+	std::vector<int> node_rows;
+	std::vector<int> node_positions;
+public:
+	m_shared_window(const size_t size, const size_t buffers,
+	                const size_t first_row, const size_t rows, const MPI_Comm comm);
+	m_shared_window(const m_shared_window &) = delete;
+	m_shared_window &operator=(const m_shared_window &) = delete;
+	~m_shared_window();
+
+	// Collective over the whole communicator: after it every process sees all rows of the buffer
+	void exchange(const size_t buffer);
+
+	type_t *get_buffer(const size_t buffer) const
+	{
+		return base + buffer * size;
+	}
+
+	bool is_leader() const
+	{
+		return node_rank == 0;
+	}
+
+	int get_node_size() const
+	{
+		return node_size;
+	}
+
+	int get_nodes() const
+	{
+		return nodes;
+	}
+};
+
+#endif //LAB02_SHARED_WINDOW_H
@@ -0,0 +1,247 @@
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include "m_trace.h"
+
+m_trace::scope::scope(m_trace &trace, const char *name) : trace(trace),
+                                                          name(name),
+                                                          communication(false),
+                                                          bytes(0),
+                                                          start(trace.enabled ? MPI_Wtime() : 0)
+{
+}
+
+m_trace::scope::scope(m_trace &trace, const char *name, const size_t bytes) : trace(trace),
+                                                                              name(name),
+                                                                              communication(true),
+                                                                              bytes(bytes),
+                                                                              start(trace.enabled ? MPI_Wtime() : 0)
+{
+}
+
+m_trace::scope::~scope()
+{
+	if (!this->trace.enabled)
+	{
+		return;
+	}
+
+	auto duration = MPI_Wtime() - this->start;
+	this->trace.events.push_back({this->trace.iteration, this->communication, this->name,
+		this->start - this->trace.origin, duration, this->bytes});
+
+	if (!this->communication && this->trace.iteration > 0 && !this->trace.iteration_compute.empty())
+	{
+		this->trace.iteration_compute.back() += duration;
+	}
+}
+
+m_trace::m_trace(const bool enabled) : enabled(enabled)
+{
+}
+
+void m_trace::start(const MPI_Comm comm)
+{
+	if (!this->enabled)
+	{
+		return;
+	}
+
+	MPI_Comm_rank(comm, &this->process_id);
+	MPI_Comm_size(comm, &this->total_processes);
+
+	// Wtime clocks are not synchronized, the barrier gives all of them a common zero
+	MPI_Barrier(comm);
+	this->origin = MPI_Wtime();
+}
+
+void m_trace::set_iteration(const size_t iteration)
+{
+	if (!this->enabled)
+	{
+		return;
+	}
+
+	this->iteration = iteration;
+	if (iteration > 0)
+	{
+		this->iteration_compute.push_back(0);
+	}
+}
+
+void m_trace::set_residual(const double value)
+{
+	if (this->enabled)
+	{
+		this->residuals.push_back({this->iteration, MPI_Wtime() - this->origin, value});
+	}
+}
+
+std::string m_trace::format_microseconds(const double seconds)
+{
+	// The default six significant digits would drop below-millisecond detail after a second of run time
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(3) << seconds * 1e6;
+	return ss.str();
+}
+
+std::string m_trace::get_csv() const
+{
+	std::stringstream ss;
+
+	for (auto &e : this->events)
+	{
+		ss << this->process_id << "," << e.iteration << "," << (e.communication ? "mpi" : "compute") << ","
+			<< e.name << "," << format_microseconds(e.start) << "," << format_microseconds(e.duration) << "," << e.bytes << ",\n";
+	}
+	for (auto &r : this->residuals)
+	{
+		ss << this->process_id << "," << r.iteration << ",residual,residual," << format_microseconds(r.time) << ",0,0,"
+			<< r.value << "\n";
+	}
+
+	return ss.str();
+}
+
+std::string m_trace::get_json() const
+{
+	std::stringstream ss;
+
+	// Complete events on one timeline row per process, residuals as a counter track
+	for (auto &e : this->events)
+	{
+		ss << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"" << (e.communication ? "mpi" : "compute")
+			<< "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << this->process_id
+			<< ",\"ts\":" << format_microseconds(e.start) << ",\"dur\":" << format_microseconds(e.duration)
+			<< ",\"args\":{\"iteration\":" << e.iteration << ",\"bytes\":" << e.bytes << "}}";
+	}
+	for (auto &r : this->residuals)
+	{
+		// JSON has no inf or nan, so a diverged residual is left off the counter track
+		if (!std::isfinite(r.value))
+		{
+			continue;
+		}
+		ss << ",\n{\"name\":\"residual\",\"ph\":\"C\",\"pid\":0,\"tid\":" << this->process_id
+			<< ",\"ts\":" << format_microseconds(r.time) << ",\"args\":{\"rank " << this->process_id << "\":" << r.value << "}}";
+	}
+
+	return ss.str();
+}
+
+std::string m_trace::gather(const std::string &local, const MPI_Comm comm) const
+{
+	auto length = static_cast<int>(local.size());
+	std::vector<int> lengths(this->total_processes), positions(this->total_processes, 0);
+
+	MPI_Gather(&length, 1, MPI_INT, lengths.data(), 1, MPI_INT, 0, comm);
+
+	for (auto i = 1; i < this->total_processes; ++i)
+	{
+		positions[i] = positions[i - 1] + lengths[i - 1];
+	}
+
+	std::string result(this->process_id == 0 ? positions.back() + lengths.back() : 0, ' ');
+	MPI_Gatherv(local.data(), length, MPI_CHAR, &result[0], lengths.data(), positions.data(), MPI_CHAR, 0, comm);
+
+	return result;
+}
+
+void m_trace::print_summary(const MPI_Comm comm) const
+{
+	double totals[2] = {0, 0};
+	for (auto &e : this->events)
+	{
+		totals[e.communication ? 1 : 0] += e.duration;
+	}
+
+	std::vector<double> all_totals(2 * this->total_processes);
+	MPI_Gather(totals, 2, MPI_DOUBLE, all_totals.data(), 2, MPI_DOUBLE, 0, comm);
+
+	// Every process runs the same iterations, but guard against a rank that stopped early
+	auto local_iterations = static_cast<long>(this->iteration_compute.size());
+	long iterations = 0;
+	MPI_Allreduce(&local_iterations, &iterations, 1, MPI_LONG, MPI_MIN, comm);
+
+	std::vector<double> all_compute(this->process_id == 0 ? iterations * this->total_processes : 0);
+	MPI_Gather(this->iteration_compute.data(), static_cast<int>(iterations), MPI_DOUBLE,
+	           all_compute.data(), static_cast<int>(iterations), MPI_DOUBLE, 0, comm);
+
+	if (this->process_id != 0)
+	{
+		return;
+	}
+
+	// An iteration lasts as long as its slowest process computes, the others wait in the next collective
+	std::vector<long> slowest(this->total_processes, 0);
+	auto critical = 0.0;
+	auto mean = 0.0;
+	for (long k = 0; k < iterations; ++k)
+	{
+		auto rank = 0;
+		auto sum = 0.0;
+		for (auto p = 0; p < this->total_processes; ++p)
+		{
+			auto value = all_compute[p * iterations + k];
+			sum += value;
+			if (value > all_compute[rank * iterations + k])
+			{
+				rank = p;
+			}
+		}
+		slowest[rank]++;
+		critical += all_compute[rank * iterations + k];
+		mean += sum / this->total_processes;
+	}
+
+	auto critical_rank = static_cast<int>(std::max_element(slowest.begin(), slowest.end()) - slowest.begin());
+
+	std::cout << "Trace: critical path rank " << critical_rank
+		<< " (slowest in " << slowest[critical_rank] << " of " << iterations << " iterations)"
+		<< ", compute imbalance max/mean: " << (mean > 0 ? critical / mean : 1.0)
+		<< ", time lost to imbalance: " << (critical - mean) * 1000 << "ms" << std::endl;
+
+	for (auto p = 0; p < this->total_processes; ++p)
+	{
+		std::cout << "Trace: rank " << p
+			<< ", compute: " << all_totals[2 * p] * 1000 << "ms"
+			<< ", mpi: " << all_totals[2 * p + 1] * 1000 << "ms"
+			<< ", slowest in " << slowest[p] << " iterations" << std::endl;
+	}
+}
+
+void m_trace::write(const std::string &prefix, const MPI_Comm comm) const
+{
+	if (!this->enabled)
+	{
+		return;
+	}
+
+	auto csv = this->gather(this->get_csv(), comm);
+	auto json = this->gather(this->get_json(), comm);
+
+	if (this->process_id == 0)
+	{
+		std::ofstream csv_file(prefix + ".csv", std::ofstream::trunc);
+		std::ofstream json_file(prefix + ".json", std::ofstream::trunc);
+
+		if (!csv_file || !json_file)
+		{
+			throw std::runtime_error("Trace files are not ready to write: " + prefix + ".csv, " + prefix + ".json");
+		}
+
+		csv_file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+		json_file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+
+		csv_file << "rank,iteration,kind,name,start_us,duration_us,bytes,residual\n" << csv;
+		// Every fragment starts with a separator, the metadata event gives the first one something to follow
+		json_file << "{\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Lab02\"}}"
+			<< json << "\n]}\n";
+	}
+
+	this->print_summary(comm);
+}
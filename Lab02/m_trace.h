@@ -0,0 +1,77 @@
+#ifndef LAB02_TRACE_H
+#define LAB02_TRACE_H
+
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+// Per-process record of where the time of every iteration goes: compute regions,
+// MPI calls with the bytes they deliver and the residual seen at convergence checks.
+// A disabled trace costs a single branch per region.
+class m_trace
+{
+	struct event
+	{
+		size_t iteration;
+		bool communication;
+		const char *name;
+		double start;
+		double duration;
+		size_t bytes;
+	};
+
+	struct residual
+	{
+		size_t iteration;
+		double time;
+		double value;
+	};
+
+	const bool enabled;
+	int process_id = 0;
+	int total_processes = 1;
+	double origin = 0;
+	size_t iteration = 0;
+	std::vector<event> events;
+	std::vector<residual> residuals;
+	// Compute time of every iteration in the order they were run, solver after solver
+	std::vector<double> iteration_compute;
+
+	static std::string format_microseconds(const double seconds);
+	std::string get_csv() const;
+	std::string get_json() const;
+	std::string gather(const std::string &local, const MPI_Comm comm) const;
+	void print_summary(const MPI_Comm comm) const;
+public:
+	// Measures the enclosing block: a compute region, or an MPI call when bytes are given
+	class scope
+	{
+		m_trace &trace;
+		const char *const name;
+		const bool communication;
+		const size_t bytes;
+		const double start;
+	public:
+		scope(m_trace &trace, const char *name);
+		scope(m_trace &trace, const char *name, const size_t bytes);
+		scope(const scope &) = delete;
+		scope &operator=(const scope &) = delete;
+		~scope();
+	};
+
+	explicit m_trace(const bool enabled);
+
+	// Collective: aligns the clocks of the processes at a barrier
+	void start(const MPI_Comm comm);
+	void set_iteration(const size_t iteration);
+	void set_residual(const double value);
+	// Collective: writes prefix.csv and prefix.json on the root and prints the summary
+	void write(const std::string &prefix, const MPI_Comm comm) const;
+
+	bool is_enabled() const
+	{
+		return enabled;
+	}
+};
+
+#endif //LAB02_TRACE_H
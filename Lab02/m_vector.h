@@ -8,6 +8,8 @@
 
 typedef long double type_t;
 
+#define mpi_type_t MPI_LONG_DOUBLE
+
 class m_vector
 {
 	typedef std::vector<type_t> data_t;
@@ -82,4 +84,4 @@ public:
 	}
 };
 
-#endif LAB02_VECTOR_H
+#endif //LAB02_VECTOR_H
@@ -2,17 +2,36 @@
 #include <iostream>
 #include <chrono>
 #include <mpi.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 int main(int argc, char * argv[]) {
-	MPI_Init(&argc, &argv);
+	// Only the main thread talks to MPI, the row kernel threads never do
+	auto provided = 0;
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
 
     try {
 	    auto tester = mpi_tester(argc, argv);
+#ifdef _OPENMP
+		if (provided < MPI_THREAD_FUNNELED)
+		{
+			// Without funneled support the library may not be called from a threaded process at all,
+			// so the row kernel runs on the main thread only, whatever -t asked for
+			auto process_id = 0;
+			MPI_Comm_rank(MPI_COMM_WORLD, &process_id);
+			if (process_id == 0)
+			{
+				std::cerr << "MPI_THREAD_FUNNELED is not supported, running with one thread per process" << std::endl;
+			}
+			omp_set_num_threads(1);
+		}
+#endif
 		auto before = std::chrono::high_resolution_clock::now();
 		tester.init();
         tester.process();
 		auto after = std::chrono::high_resolution_clock::now();
-		auto time = std::chrono::duration_cast<std::chrono::milliseconds>(after - before).count();
+		auto time = std::chrono::duration<double, std::milli>(after - before).count();
 		std::cout << "Time taken: " << time << "ms" << std::endl;
     } catch (std::exception const &e) {
         std::cerr << "Error occurred: " << e.what() << std::endl;
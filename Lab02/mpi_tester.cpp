@@ -1,14 +1,75 @@
 #include <mpi.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <cmath>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <numeric>
 #include <algorithm>
 #include "mpi_tester.h"
 
 const std::string mpi_tester::DEFAULT_OUTPUT_FILE_NAME = "output.txt";
 const std::string mpi_tester::USE_GENERATED_MATRICES_ARG = "-g";
+const std::string mpi_tester::GENERATOR_FAMILY_ARG = "-gt";
+const std::string mpi_tester::GENERATOR_BANDWIDTH_ARG = "-gb";
+const std::string mpi_tester::GENERATOR_SEED_ARG = "-gs";
 const std::string mpi_tester::OUTPUT_FILE_ARG = "-o";
 const std::string mpi_tester::VERBOSE_ARG = "-v";
+const std::string mpi_tester::CHECK_INTERVAL_ARG = "-k";
+const std::string mpi_tester::NORM_ARG = "-norm";
+const std::string mpi_tester::STOP_CRITERION_ARG = "-stop";
+const std::string mpi_tester::L2_NORM = "l2";
+const std::string mpi_tester::MAX_NORM = "inf";
+const std::string mpi_tester::DIFFERENCE_CRITERION = "diff";
+const std::string mpi_tester::RESIDUAL_CRITERION = "residual";
+const std::string mpi_tester::OVERLAP_ARG = "-overlap";
+const std::string mpi_tester::GATHER_OVERLAP = "gather";
+const std::string mpi_tester::PIECES_OVERLAP = "pieces";
+const std::string mpi_tester::THREADS_NUMBER_ARG = "-t";
+const std::string mpi_tester::KERNEL_ARG = "-kernel";
+const std::string mpi_tester::PLAIN_KERNEL = "plain";
+const std::string mpi_tester::SIMD_KERNEL = "simd";
+const std::string mpi_tester::THREAD_SCALING_ARG = "-ts";
+const int mpi_tester::THREAD_SCALING_SWEEPS = 10;
+const std::string mpi_tester::SOLVER_ARG = "-solver";
+const std::string mpi_tester::JACOBI_SOLVER = "jacobi";
+const std::string mpi_tester::GAUSS_SEIDEL_SOLVER = "gs";
+const std::string mpi_tester::RED_BLACK_SOLVER = "rbgs";
+const std::string mpi_tester::SOR_SOLVER = "sor";
+const std::string mpi_tester::CG_SOLVER = "cg";
+const std::string mpi_tester::GMRES_SOLVER = "gmres";
+const std::string mpi_tester::BLOCK_JACOBI_SOLVER = "bjacobi";
+const std::string mpi_tester::RESTART_ARG = "-restart";
+const std::string mpi_tester::PRECONDITIONER_ARG = "-precond";
+const std::string mpi_tester::NO_PRECONDITIONER = "none";
+const std::string mpi_tester::JACOBI_PRECONDITIONER = "jacobi";
+const std::string mpi_tester::SPARSE_ARG = "-sparse";
+const std::string mpi_tester::PARTITION_ARG = "-partition";
+const std::string mpi_tester::ROWS_PARTITION = "rows";
+const std::string mpi_tester::NONZEROS_PARTITION = "nnz";
+const std::string mpi_tester::COST_PARTITION = "cost";
+const int mpi_tester::COST_MEASUREMENT_REPEATS = 5;
+const std::string mpi_tester::GRID_ARG = "-grid";
+const std::string mpi_tester::GRID_BLOCK_ARG = "-nb";
+const std::string mpi_tester::OMEGA_ARG = "-omega";
+const std::string mpi_tester::AUTO_OMEGA = "auto";
+const std::string mpi_tester::COMPARE_ARG = "-compare";
+const std::string mpi_tester::INITIAL_GUESS_ARG = "-x";
+const std::string mpi_tester::INITIAL_GUESS_FORMAT_ARG = "-xf";
+const std::string mpi_tester::TEXT_FORMAT = "text";
+const std::string mpi_tester::BINARY_FORMAT = "binary";
+const std::string mpi_tester::COLD_START_ARG = "-cold";
+const std::string mpi_tester::TRACE_ARG = "-trace";
+const std::string mpi_tester::ACCELERATION_ARG = "-accel";
+const std::string mpi_tester::NO_ACCELERATION = "none";
+const std::string mpi_tester::CHEBYSHEV_ACCELERATION = "chebyshev";
+const std::string mpi_tester::ANDERSON_ACCELERATION = "anderson";
+const std::string mpi_tester::RADIUS_ARG = "-rho";
+const std::string mpi_tester::DEPTH_ARG = "-depth";
+const std::string mpi_tester::SHARED_ARG = "-shared";
+const size_t mpi_tester::RADIUS_ESTIMATION_ITERATIONS = 20;
 const int mpi_tester::ROOT_ID = 0;
 
 void mpi_tester::read_matrix()
@@ -30,12 +91,24 @@ void mpi_tester::read_matrix()
 
 	input_file.close();
 
-	auto pair = full_matrix->split();
+	if (n > m + 1)
+	{
+		auto pair = full_matrix->split(n - m);
+
+		this->coeff_matrix = pair.first;
+		this->right_hand_block = pair.second;
+		this->right_hand_columns = n - m;
+	}
+	else
+	{
+		auto pair = full_matrix->split();
+
+		this->coeff_matrix = pair.first;
+		this->right_hand_side = pair.second;
+	}
 
-	this->coeff_matrix = pair.first;
-	this->right_hand_side = pair.second;
 	this->matrix_rows = (*this->coeff_matrix).get_rows();
-	this->matrix_columns = this->matrix_rows + 1;
+	this->matrix_columns = this->matrix_rows + this->right_hand_columns;
 }
 
 void mpi_tester::check_range() const
@@ -67,22 +140,136 @@ void mpi_tester::print_answer() const
 
 	out_file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
 
-	out_file << *this->approximation;
+	if (this->right_hand_columns > 1)
+	{
+		// One line per unknown with its value for every right-hand side
+		out_file << this->get_size() << " " << this->right_hand_columns << std::endl;
+		for (size_t i = 0; i < this->get_size(); ++i)
+		{
+			for (size_t c = 0; c < this->right_hand_columns; ++c)
+			{
+				out_file << (*this->approximation_block)[i][c] << (c + 1 < this->right_hand_columns ? " " : "");
+			}
+			out_file << std::endl;
+		}
+	}
+	else
+	{
+		out_file << *this->approximation;
+	}
 
 	out_file.close();
 }
 
-double mpi_tester::distance(m_vector::vector_t &new_appr, m_vector::vector_t &old_appr)
+void mpi_tester::gather_approximation_block() const
+{
+	auto k = static_cast<int>(this->right_hand_columns);
+	auto rows = (*this->rows_number_distribution)[this->process_id];
+	std::vector<int> block_number(this->total_processes), block_positions(this->total_processes);
+
+	for (auto i = 0; i < this->total_processes; ++i)
+	{
+		block_number[i] = (*this->rows_number_distribution)[i] * k;
+		block_positions[i] = (*this->rows_positions_distribution)[i] * k;
+	}
+
+	auto local = this->approximation_block->get_plain_data();
+	auto plain_block_data = std::make_shared<std::vector<type_t>>(
+		this->process_id == this->ROOT_ID ? this->get_size() * k : 0);
+
+	MPI_Gatherv(local->data(), rows * k, mpi_type_t,
+	            plain_block_data->data(), block_number.data(), block_positions.data(), mpi_type_t,
+	            this->ROOT_ID, MPI_COMM_WORLD);
+
+	if (this->process_id == this->ROOT_ID)
+	{
+		this->approximation_block->fill(plain_block_data, plain_block_data->size());
+	}
+}
+
+void mpi_tester::accumulate_norm(double &local_part, const type_t value) const
+{
+	auto abs_value = std::fabs(static_cast<double>(value));
+
+	if (this->norm == MAX_NORM)
+	{
+		local_part = std::max(local_part, abs_value);
+	}
+	else
+	{
+		local_part += abs_value * abs_value;
+	}
+}
+
+double mpi_tester::reduce_norm(const double local_part) const
+{
+	m_trace::scope region(*this->trace, "MPI_Allreduce", sizeof(double));
+	auto global = 0.0;
+	MPI_Allreduce(&local_part, &global, 1, MPI_DOUBLE,
+	              this->norm == MAX_NORM ? MPI_MAX : MPI_SUM, MPI_COMM_WORLD);
+
+	return this->norm == MAX_NORM ? global : std::sqrt(global);
+}
+
+std::vector<double> mpi_tester::reduce_norms(const std::vector<double> &local_parts) const
+{
+	m_trace::scope region(*this->trace, "MPI_Allreduce", local_parts.size() * sizeof(double));
+	std::vector<double> global(local_parts.size());
+	MPI_Allreduce(local_parts.data(), global.data(), static_cast<int>(local_parts.size()), MPI_DOUBLE,
+	              this->norm == MAX_NORM ? MPI_MAX : MPI_SUM, MPI_COMM_WORLD);
+
+	if (this->norm != MAX_NORM)
+	{
+		for (auto &value : global)
+		{
+			value = std::sqrt(value);
+		}
+	}
+
+	return global;
+}
+
+bool mpi_tester::is_check_iteration(const size_t iteration) const
+{
+	return iteration % this->check_interval == 0 || iteration >= this->max_iterations;
+}
+
+double mpi_tester::get_right_hand_norm() const
 {
-	auto size = new_appr->get_size();
-	auto sum = 0.0;
+	if (this->stop_criterion != RESIDUAL_CRITERION)
+	{
+		return 1.0;
+	}
 
-	for (auto i = 0; i < size; ++i)
+	auto rows = (*this->rows_number_distribution)[this->process_id];
+	auto local_part = 0.0;
+
+	for (auto i = 0; i < rows; ++i)
 	{
-		sum += ((*new_appr)[i] - (*old_appr)[i]) * ((*new_appr)[i] - (*old_appr)[i]);
+		this->accumulate_norm(local_part, (*this->right_hand_side)[i]);
 	}
 
-	return sqrt(sum);
+	auto result = this->reduce_norm(local_part);
+	return result == 0.0 ? 1.0 : result;
+}
+
+void mpi_tester::subtract_columns(std::vector<type_t> &partial, const m_vector &x, const size_t x_offset,
+                                  const size_t first_column, const size_t last_column) const
+{
+	auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+
+	for (size_t i = 0; i < partial.size(); ++i)
+	{
+		auto g = first_row + i;
+		auto &row = (*this->coeff_matrix)[i];
+		for (auto j = first_column; j < last_column; ++j)
+		{
+			if (j != g)
+			{
+				partial[i] -= row[j] * x[j - x_offset];
+			}
+		}
+	}
 }
 
 void mpi_tester::check_arguments_available(const int total, const int current, const int required)
@@ -99,6 +286,36 @@ std::string mpi_tester::get_help()
 	ss << "Usage: Lab02 "
 		<< "[" << OUTPUT_FILE_ARG << " output_path] "
 		<< "[" << USE_GENERATED_MATRICES_ARG << " rows] "
+		<< "[" << GENERATOR_FAMILY_ARG << " " << m_generator::TRIANGULAR_FAMILY << "|"
+		<< m_generator::DOMINANT_FAMILY << "|" << m_generator::BANDED_FAMILY << "] "
+		<< "[" << GENERATOR_BANDWIDTH_ARG << " bandwidth] "
+		<< "[" << GENERATOR_SEED_ARG << " seed] "
+		<< "[" << CHECK_INTERVAL_ARG << " check_every_k_iterations] "
+		<< "[" << NORM_ARG << " " << L2_NORM << "|" << MAX_NORM << "] "
+		<< "[" << STOP_CRITERION_ARG << " " << DIFFERENCE_CRITERION << "|" << RESIDUAL_CRITERION << "] "
+		<< "[" << OVERLAP_ARG << " " << GATHER_OVERLAP << "|" << PIECES_OVERLAP << "] "
+		<< "[" << KERNEL_ARG << " " << PLAIN_KERNEL << "|" << SIMD_KERNEL << "] "
+		<< "[" << THREADS_NUMBER_ARG << " threads] "
+		<< "[" << THREAD_SCALING_ARG << "] "
+		<< "[" << SOLVER_ARG << " " << JACOBI_SOLVER << "|" << GAUSS_SEIDEL_SOLVER << "|"
+		<< RED_BLACK_SOLVER << "|" << SOR_SOLVER << "|" << CG_SOLVER << "|" << GMRES_SOLVER << "|"
+		<< BLOCK_JACOBI_SOLVER << "] "
+		<< "[" << RESTART_ARG << " gmres_restart] "
+		<< "[" << PRECONDITIONER_ARG << " " << NO_PRECONDITIONER << "|" << JACOBI_PRECONDITIONER << "] "
+		<< "[" << SPARSE_ARG << "] "
+		<< "[" << PARTITION_ARG << " " << ROWS_PARTITION << "|" << NONZEROS_PARTITION << "|" << COST_PARTITION << "] "
+		<< "[" << GRID_ARG << " [" << GRID_BLOCK_ARG << " block_size]] "
+		<< "[" << OMEGA_ARG << " omega|" << AUTO_OMEGA << "] "
+		<< "[" << COMPARE_ARG << "] "
+		<< "[" << INITIAL_GUESS_ARG << " initial_approximation_path "
+		<< "[" << INITIAL_GUESS_FORMAT_ARG << " " << TEXT_FORMAT << "|" << BINARY_FORMAT << "] "
+		<< "[" << COLD_START_ARG << "]] "
+		<< "[" << TRACE_ARG << " trace_files_prefix] "
+		<< "[" << ACCELERATION_ARG << " " << NO_ACCELERATION << "|" << CHEBYSHEV_ACCELERATION << "|"
+		<< ANDERSON_ACCELERATION << "] "
+		<< "[" << RADIUS_ARG << " jacobi_spectral_radius] "
+		<< "[" << DEPTH_ARG << " anderson_depth] "
+		<< "[" << SHARED_ARG << "] "
 		<< "input_file_matrix input_file_approximation precision max_iterations";
 	return ss.str();
 }
@@ -120,14 +337,251 @@ void mpi_tester::calculate_data_distribution()
 		auto current = static_cast<int>(std::min(left, this->rows_per_process));
 		(*this->rows_number_distribution)[i] = current;
 		(*this->rows_positions_distribution)[i] = row;
-		(*this->cells_number_distribution)[i] = current * static_cast<int>(this->get_size());
-		(*this->cells_positions_distribution)[i] = row * static_cast<int>(this->get_size());
+		// Sparse stripes are not moved as dense cells, and their n * rows would not fit an int
+		(*this->cells_number_distribution)[i] = this->sparse ? 0 : current * static_cast<int>(this->get_size());
+		(*this->cells_positions_distribution)[i] = this->sparse ? 0 : row * static_cast<int>(this->get_size());
 		row += current;
 	}
 
 	this->print_data_distribution();
 }
 
+std::vector<double> mpi_tester::measure_row_weights() const
+{
+	auto rows = static_cast<size_t>((*this->rows_number_distribution)[this->process_id]);
+	std::vector<double> weights(rows, 0.0);
+
+	if (this->partition == NONZEROS_PARTITION)
+	{
+		for (size_t i = 0; i < rows; ++i)
+		{
+			if (this->sparse)
+			{
+				weights[i] = static_cast<double>(this->sparse_matrix->get_row_starts()[i + 1]
+					- this->sparse_matrix->get_row_starts()[i]);
+			}
+			else
+			{
+				auto &row = *(*this->coeff_matrix)[i].get_data();
+				weights[i] = static_cast<double>(std::count_if(row.begin(), row.end(), [](const type_t value)
+				                                               {
+					                                               return value != 0;
+				                                               }));
+			}
+		}
+
+		return weights;
+	}
+
+	// Measured cost: time the row update of the solver kernel against a vector of ones
+	auto ones = std::make_shared<m_vector>(this->get_size());
+	std::fill(ones->get_data()->begin(), ones->get_data()->end(), static_cast<type_t>(1));
+	volatile type_t sink = 0;
+
+	for (size_t i = 0; i < rows; ++i)
+	{
+		auto before = MPI_Wtime();
+		for (auto r = 0; r < COST_MEASUREMENT_REPEATS; ++r)
+		{
+			if (this->sparse)
+			{
+				type_t sum = 0;
+				auto &row_starts = this->sparse_matrix->get_row_starts();
+				for (auto k = row_starts[i]; k < row_starts[i + 1]; ++k)
+				{
+					sum += this->sparse_matrix->get_values()[k] * (*ones)[this->sparse_matrix->get_columns()[k]];
+				}
+				sink = sink + sum;
+			}
+			else
+			{
+				sink = sink + this->row_update(i, *ones);
+			}
+		}
+		weights[i] = (MPI_Wtime() - before) / COST_MEASUREMENT_REPEATS;
+	}
+
+	return weights;
+}
+
+void mpi_tester::rebalance()
+{
+	auto rows = (*this->rows_number_distribution)[this->process_id];
+	auto local_weights = this->measure_row_weights();
+	std::vector<double> weights(this->get_size());
+
+	MPI_Allgatherv(local_weights.data(), rows, MPI_DOUBLE,
+	               weights.data(), this->rows_number_distribution->data(),
+	               this->rows_positions_distribution->data(), MPI_DOUBLE, MPI_COMM_WORLD);
+
+	// Every process cuts the same prefix sums, so the new distribution needs no communication
+	auto total = std::accumulate(weights.begin(), weights.end(), 0.0);
+	std::vector<int> new_rows_number(this->total_processes, 0);
+	std::vector<int> new_rows_positions(this->total_processes, 0);
+	size_t row = 0;
+	auto prefix = 0.0;
+
+	for (auto p = 0; p < this->total_processes; ++p)
+	{
+		new_rows_positions[p] = static_cast<int>(row);
+		auto target = total * (p + 1) / this->total_processes;
+
+		if (p == this->total_processes - 1)
+		{
+			row = this->get_size();
+		}
+		else
+		{
+			// A row goes to the process holding the larger part of its weight
+			while (row < this->get_size() && prefix + weights[row] / 2 <= target)
+			{
+				prefix += weights[row++];
+			}
+		}
+		new_rows_number[p] = static_cast<int>(row) - new_rows_positions[p];
+	}
+
+	this->migrate_rows(new_rows_number, new_rows_positions);
+
+	auto first_row = new_rows_positions[this->process_id];
+	auto own_weight = std::accumulate(weights.begin() + first_row,
+	                                  weights.begin() + first_row + new_rows_number[this->process_id], 0.0);
+	auto mean_weight = total / this->total_processes;
+	auto ratio = mean_weight > 0 ? own_weight / mean_weight : 1.0;
+	auto max_ratio = 0.0;
+
+	MPI_Reduce(&ratio, &max_ratio, 1, MPI_DOUBLE, MPI_MAX, this->ROOT_ID, MPI_COMM_WORLD);
+
+	std::stringstream ss;
+	ss << "Partition by " << this->partition << ": rows " << new_rows_number[this->process_id]
+		<< ", weight " << own_weight << ", load imbalance ratio " << ratio;
+	auto msg = ss.str();
+	log(msg);
+
+	if (this->process_id == this->ROOT_ID)
+	{
+		std::cout << "Load imbalance (max/mean " << this->partition << "): " << max_ratio << std::endl;
+	}
+}
+
+void mpi_tester::migrate_rows(const std::vector<int> &new_rows_number, const std::vector<int> &new_rows_positions)
+{
+	auto n = static_cast<int>(this->get_size());
+	auto old_first = (*this->rows_positions_distribution)[this->process_id];
+	auto old_last = old_first + (*this->rows_number_distribution)[this->process_id];
+	auto new_first = new_rows_positions[this->process_id];
+	auto new_last = new_first + new_rows_number[this->process_id];
+	auto new_rows = new_rows_number[this->process_id];
+
+	// Row ranges are contiguous, so every pair of processes exchanges one interval of rows
+	std::vector<int> send_rows(this->total_processes, 0), send_first(this->total_processes, 0);
+	std::vector<int> recv_rows(this->total_processes, 0), recv_first(this->total_processes, 0);
+
+	for (auto p = 0; p < this->total_processes; ++p)
+	{
+		auto send_begin = std::max(old_first, new_rows_positions[p]);
+		auto send_end = std::min(old_last, new_rows_positions[p] + new_rows_number[p]);
+		send_rows[p] = std::max(0, send_end - send_begin);
+		send_first[p] = send_rows[p] ? send_begin - old_first : 0;
+
+		auto p_first = (*this->rows_positions_distribution)[p];
+		auto recv_begin = std::max(new_first, p_first);
+		auto recv_end = std::min(new_last, p_first + (*this->rows_number_distribution)[p]);
+		recv_rows[p] = std::max(0, recv_end - recv_begin);
+		recv_first[p] = recv_rows[p] ? recv_begin - new_first : 0;
+	}
+
+	auto new_right_hand_side = std::make_shared<m_vector>(new_rows);
+	MPI_Alltoallv(this->right_hand_side->get_data()->data(), send_rows.data(), send_first.data(), mpi_type_t,
+	              new_right_hand_side->get_data()->data(), recv_rows.data(), recv_first.data(), mpi_type_t,
+	              MPI_COMM_WORLD);
+
+	if (this->sparse)
+	{
+		auto &row_starts = this->sparse_matrix->get_row_starts();
+		std::vector<int> lengths(row_starts.size() - 1), new_lengths(new_rows);
+		for (size_t i = 0; i + 1 < row_starts.size(); ++i)
+		{
+			lengths[i] = static_cast<int>(row_starts[i + 1] - row_starts[i]);
+		}
+		MPI_Alltoallv(lengths.data(), send_rows.data(), send_first.data(), MPI_INT,
+		              new_lengths.data(), recv_rows.data(), recv_first.data(), MPI_INT, MPI_COMM_WORLD);
+
+		std::vector<int> send_entries(this->total_processes), send_entries_first(this->total_processes);
+		std::vector<int> recv_entries(this->total_processes), recv_entries_first(this->total_processes);
+		std::vector<size_t> new_row_starts(new_rows + 1, 0);
+		for (auto i = 0; i < new_rows; ++i)
+		{
+			new_row_starts[i + 1] = new_row_starts[i] + new_lengths[i];
+		}
+		for (auto p = 0; p < this->total_processes; ++p)
+		{
+			send_entries_first[p] = static_cast<int>(row_starts[send_first[p]]);
+			send_entries[p] = static_cast<int>(row_starts[send_first[p] + send_rows[p]]) - send_entries_first[p];
+			recv_entries_first[p] = static_cast<int>(new_row_starts[recv_first[p]]);
+			recv_entries[p] = static_cast<int>(new_row_starts[recv_first[p] + recv_rows[p]]) - recv_entries_first[p];
+		}
+
+		std::vector<unsigned long long> columns(this->sparse_matrix->get_columns().begin(),
+		                                        this->sparse_matrix->get_columns().end());
+		std::vector<unsigned long long> new_columns(new_row_starts[new_rows]);
+		std::vector<type_t> new_values(new_row_starts[new_rows]);
+		MPI_Alltoallv(columns.data(), send_entries.data(), send_entries_first.data(), MPI_UNSIGNED_LONG_LONG,
+		              new_columns.data(), recv_entries.data(), recv_entries_first.data(), MPI_UNSIGNED_LONG_LONG,
+		              MPI_COMM_WORLD);
+		MPI_Alltoallv(this->sparse_matrix->get_values().data(), send_entries.data(), send_entries_first.data(), mpi_type_t,
+		              new_values.data(), recv_entries.data(), recv_entries_first.data(), mpi_type_t,
+		              MPI_COMM_WORLD);
+
+		this->sparse_matrix = std::make_shared<m_csr_matrix>(new_rows);
+		for (auto i = 0; i < new_rows; ++i)
+		{
+			for (auto k = new_row_starts[i]; k < new_row_starts[i + 1]; ++k)
+			{
+				this->sparse_matrix->push(new_columns[k], new_values[k]);
+			}
+			this->sparse_matrix->next_row();
+		}
+	}
+	else
+	{
+		// The root still holds the whole matrix after a scatter, its own rows come first either way
+		auto plain_data = this->coeff_matrix->get_plain_data();
+		auto new_plain_data = std::make_shared<std::vector<type_t>>(static_cast<size_t>(new_rows) * n);
+		std::vector<int> send_cells(this->total_processes), send_cells_first(this->total_processes);
+		std::vector<int> recv_cells(this->total_processes), recv_cells_first(this->total_processes);
+
+		for (auto p = 0; p < this->total_processes; ++p)
+		{
+			send_cells[p] = send_rows[p] * n;
+			send_cells_first[p] = send_first[p] * n;
+			recv_cells[p] = recv_rows[p] * n;
+			recv_cells_first[p] = recv_first[p] * n;
+		}
+
+		MPI_Alltoallv(plain_data->data(), send_cells.data(), send_cells_first.data(), mpi_type_t,
+		              new_plain_data->data(), recv_cells.data(), recv_cells_first.data(), mpi_type_t,
+		              MPI_COMM_WORLD);
+
+		this->coeff_matrix = std::make_shared<m_matrix>(new_rows, this->get_size());
+		this->coeff_matrix->fill(new_plain_data, new_plain_data->size());
+	}
+
+	this->right_hand_side = new_right_hand_side;
+	*this->rows_number_distribution = new_rows_number;
+	*this->rows_positions_distribution = new_rows_positions;
+	this->rows_per_process = static_cast<size_t>(*std::max_element(new_rows_number.begin(), new_rows_number.end()));
+	this->cells_per_process = this->get_size() * this->rows_per_process;
+
+	for (auto p = 0; p < this->total_processes; ++p)
+	{
+		(*this->cells_number_distribution)[p] = this->sparse ? 0 : new_rows_number[p] * n;
+		(*this->cells_positions_distribution)[p] = this->sparse ? 0 : new_rows_positions[p] * n;
+	}
+
+	this->print_data_distribution();
+}
+
 void mpi_tester::print_data_distribution() const
 {
 	if (this->verbose)
@@ -227,6 +681,167 @@ mpi_tester::mpi_tester(const int argc, const char *const argv[])
 			this->matrix_columns = this->matrix_rows + 1;
 			this->use_gen_input = true;
 		}
+		else if (current == this->GENERATOR_FAMILY_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->generator_family = std::string(argv[i++ + 1]);
+		}
+		else if (current == this->GENERATOR_BANDWIDTH_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->generator_bandwidth = parse_size_t(argv[i++ + 1],
+			                                         "Non-integer parameter passed as matrix bandwidth! ",
+			                                         "Too large value passed as matrix bandwidth! ");
+		}
+		else if (current == this->GENERATOR_SEED_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->generator_seed = parse_size_t(argv[i++ + 1],
+			                                    "Non-integer parameter passed as generator seed! ",
+			                                    "Too large value passed as generator seed! ");
+		}
+		else if (current == this->CHECK_INTERVAL_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->check_interval = parse_size_t(argv[i++ + 1],
+			                                    "Non-integer parameter passed as convergence check interval! ",
+			                                    "Too large value passed as convergence check interval! ");
+		}
+		else if (current == this->NORM_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->norm = std::string(argv[i++ + 1]);
+		}
+		else if (current == this->STOP_CRITERION_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->stop_criterion = std::string(argv[i++ + 1]);
+		}
+		else if (current == this->OVERLAP_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->overlap_mode = std::string(argv[i++ + 1]);
+		}
+		else if (current == this->KERNEL_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->kernel = std::string(argv[i++ + 1]);
+		}
+		else if (current == this->THREADS_NUMBER_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->threads = parse_int(argv[i++ + 1],
+			                          "Non-integer parameter passed as threads number! ",
+			                          "Too large value passed as threads number! ");
+#ifdef _OPENMP
+			if (this->threads > 0)
+			{
+				omp_set_num_threads(this->threads);
+			}
+#endif
+		}
+		else if (current == this->THREAD_SCALING_ARG)
+		{
+			this->thread_scaling = true;
+		}
+		else if (current == this->SOLVER_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->solver = std::string(argv[i++ + 1]);
+		}
+		else if (current == this->OMEGA_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			if (std::string(argv[i + 1]) == AUTO_OMEGA)
+			{
+				this->auto_omega = true;
+				++i;
+			}
+			else
+			{
+				this->omega = parse_double(argv[i++ + 1],
+				                           "Non-floating-point parameter passed as relaxation factor! ",
+				                           "Too large value passed as relaxation factor! ");
+			}
+		}
+		else if (current == this->RESTART_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->restart = parse_size_t(argv[i++ + 1],
+			                             "Non-integer parameter passed as GMRES restart length! ",
+			                             "Too large value passed as GMRES restart length! ");
+		}
+		else if (current == this->PRECONDITIONER_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->preconditioner = std::string(argv[i++ + 1]);
+		}
+		else if (current == this->SPARSE_ARG)
+		{
+			this->sparse = true;
+		}
+		else if (current == this->PARTITION_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->partition = std::string(argv[i++ + 1]);
+		}
+		else if (current == this->GRID_ARG)
+		{
+			this->use_grid = true;
+		}
+		else if (current == this->GRID_BLOCK_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->grid_block = parse_size_t(argv[i++ + 1],
+			                                "Non-integer parameter passed as grid block size! ",
+			                                "Too large value passed as grid block size! ");
+		}
+		else if (current == this->COMPARE_ARG)
+		{
+			this->compare = true;
+		}
+		else if (current == this->INITIAL_GUESS_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->initial_guess_file = std::string(argv[i++ + 1]);
+		}
+		else if (current == this->INITIAL_GUESS_FORMAT_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->initial_guess_format = std::string(argv[i++ + 1]);
+		}
+		else if (current == this->COLD_START_ARG)
+		{
+			this->cold_start = true;
+		}
+		else if (current == this->TRACE_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->trace_prefix = std::string(argv[i++ + 1]);
+		}
+		else if (current == this->ACCELERATION_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->acceleration = std::string(argv[i++ + 1]);
+		}
+		else if (current == this->RADIUS_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->radius = parse_double(argv[i++ + 1],
+			                            "Non-floating-point parameter passed as spectral radius! ",
+			                            "Too large value passed as spectral radius! ");
+		}
+		else if (current == this->SHARED_ARG)
+		{
+			this->use_shared = true;
+		}
+		else if (current == this->DEPTH_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->depth = parse_size_t(argv[i++ + 1],
+			                           "Non-integer parameter passed as Anderson depth! ",
+			                           "Too large value passed as Anderson depth! ");
+		}
 		else if (current == this->VERBOSE_ARG)
 		{
 			this->verbose = true;
@@ -254,6 +869,8 @@ mpi_tester::mpi_tester(const int argc, const char *const argv[])
 		this->output_file = this->DEFAULT_OUTPUT_FILE_NAME;
 	}
 
+	this->trace = std::make_shared<m_trace>(!this->trace_prefix.empty());
+
 	try
 	{
 		check_arguments();
@@ -278,55 +895,547 @@ void mpi_tester::check_arguments() const
 	{
 		throw std::invalid_argument("Maximum iterations number has not been passed!");
 	}
-}
-
-void mpi_tester::print_process_id() const
-{
-	if (this->verbose)
+	if (this->check_interval == 0)
 	{
-		std::cout << "[" << this->process_id << "] ";
+		throw std::invalid_argument("Convergence check interval must be positive!");
 	}
-}
-
-void mpi_tester::init()
-{
-	MPI_Comm_size(MPI_COMM_WORLD, &this->total_processes);
-	MPI_Comm_rank(MPI_COMM_WORLD, &this->process_id);
-
-	if (this->process_id == this->ROOT_ID)
+	if (this->norm != L2_NORM && this->norm != MAX_NORM)
 	{
-		if (this->use_gen_input)
-		{
-			log("Generating matrix and approximation");
-			this->coeff_matrix = m_matrix::generate_matrix(this->matrix_rows, this->matrix_rows);
-			this->right_hand_side = m_vector::generate_vector(this->matrix_rows);
-			this->approximation = m_vector::generate_vector(this->matrix_rows);
-		}
-		else
-		{
-			log("Reading matrix and approximation");
-			this->read_matrix();
-			this->approximation = std::make_shared<m_vector>(this->matrix_rows);
-		}
-		this->calculate_data_distribution();
-		this->check_range();
-		this->send_meta_data();
-		this->send_initial_data();
+		throw std::invalid_argument("Unknown norm: " + this->norm + "!");
 	}
-	else
+	if (this->stop_criterion != DIFFERENCE_CRITERION && this->stop_criterion != RESIDUAL_CRITERION)
 	{
-		this->receive_meta_data();
-		this->calculate_data_distribution();
-		this->receive_initial_data();
+		throw std::invalid_argument("Unknown stopping criterion: " + this->stop_criterion + "!");
 	}
-}
-
-std::string mpi_tester::get_metadata() const
-{
-	std::stringstream ss;
-	ss << "n: " << this->get_size()
-		<< ", precision: " << this->precision
-		<< ", max_iterations: " << this->max_iterations
+	if (!this->overlap_mode.empty() && this->overlap_mode != GATHER_OVERLAP && this->overlap_mode != PIECES_OVERLAP)
+	{
+		throw std::invalid_argument("Unknown overlap mode: " + this->overlap_mode + "!");
+	}
+	if (this->kernel != PLAIN_KERNEL && this->kernel != SIMD_KERNEL)
+	{
+		throw std::invalid_argument("Unknown row kernel: " + this->kernel + "!");
+	}
+	if (this->kernel == SIMD_KERNEL && !this->overlap_mode.empty())
+	{
+		throw std::invalid_argument("The " + SIMD_KERNEL + " row kernel can't be combined with overlap modes!");
+	}
+	if (this->threads < 0)
+	{
+		throw std::invalid_argument("Threads number must be positive!");
+	}
+	if (this->solver != JACOBI_SOLVER && this->solver != GAUSS_SEIDEL_SOLVER &&
+		this->solver != RED_BLACK_SOLVER && this->solver != SOR_SOLVER &&
+		this->solver != CG_SOLVER && this->solver != GMRES_SOLVER && this->solver != BLOCK_JACOBI_SOLVER)
+	{
+		throw std::invalid_argument("Unknown solver: " + this->solver + "!");
+	}
+	if (this->restart == 0)
+	{
+		throw std::invalid_argument("GMRES restart length must be positive!");
+	}
+	if (this->preconditioner != NO_PRECONDITIONER && this->preconditioner != JACOBI_PRECONDITIONER)
+	{
+		throw std::invalid_argument("Unknown preconditioner: " + this->preconditioner + "!");
+	}
+	if (this->partition != ROWS_PARTITION && this->partition != NONZEROS_PARTITION &&
+		this->partition != COST_PARTITION)
+	{
+		throw std::invalid_argument("Unknown partition: " + this->partition + "!");
+	}
+	if (this->use_grid && (this->solver != JACOBI_SOLVER || this->sparse || this->kernel != PLAIN_KERNEL ||
+		!this->overlap_mode.empty() || this->partition != ROWS_PARTITION))
+	{
+		throw std::invalid_argument("2D process grid supports only the plain dense " + JACOBI_SOLVER + " solver!");
+	}
+	if (this->grid_block == 0)
+	{
+		throw std::invalid_argument("Grid block size must be positive!");
+	}
+	if (this->sparse && (this->solver != JACOBI_SOLVER || this->kernel != PLAIN_KERNEL || !this->overlap_mode.empty()))
+	{
+		throw std::invalid_argument("Sparse storage supports only the plain " + JACOBI_SOLVER + " solver!");
+	}
+	if (this->initial_guess_format != TEXT_FORMAT && this->initial_guess_format != BINARY_FORMAT)
+	{
+		throw std::invalid_argument("Unknown initial approximation format: " + this->initial_guess_format + "!");
+	}
+	if (this->cold_start && this->initial_guess_file.empty())
+	{
+		throw std::invalid_argument("Cold start comparison requires an initial approximation!");
+	}
+	if (!this->initial_guess_file.empty() && this->use_grid)
+	{
+		throw std::invalid_argument("2D process grid can't start from an initial approximation!");
+	}
+	if (this->acceleration != NO_ACCELERATION && this->acceleration != CHEBYSHEV_ACCELERATION &&
+		this->acceleration != ANDERSON_ACCELERATION)
+	{
+		throw std::invalid_argument("Unknown acceleration: " + this->acceleration + "!");
+	}
+	if (this->acceleration != NO_ACCELERATION && (this->solver != JACOBI_SOLVER || this->sparse || this->use_grid ||
+		this->kernel != PLAIN_KERNEL || !this->overlap_mode.empty()))
+	{
+		throw std::invalid_argument("Acceleration applies only to the plain dense " + JACOBI_SOLVER + " solver!");
+	}
+	if (this->use_shared && (this->solver != JACOBI_SOLVER || this->sparse || this->use_grid ||
+		this->kernel != PLAIN_KERNEL || !this->overlap_mode.empty() || this->acceleration != NO_ACCELERATION))
+	{
+		throw std::invalid_argument("Shared windows apply only to the plain dense " + JACOBI_SOLVER + " solver!");
+	}
+	if (this->radius < 0 || this->radius >= 1)
+	{
+		throw std::invalid_argument("Spectral radius bound must lie in [0, 1)!");
+	}
+	if (this->depth == 0)
+	{
+		throw std::invalid_argument("Anderson depth must be positive!");
+	}
+	if (this->omega <= 0 || this->omega >= 2)
+	{
+		throw std::invalid_argument("Relaxation factor must lie in (0, 2)!");
+	}
+}
+
+void mpi_tester::check_right_hand_columns() const
+{
+	if (this->right_hand_columns > 1 && this->use_shared)
+	{
+		throw std::invalid_argument("Several right-hand sides can't be solved in shared windows!");
+	}
+	if (this->right_hand_columns > 1 && this->acceleration != NO_ACCELERATION)
+	{
+		throw std::invalid_argument("Several right-hand sides can't be solved with acceleration!");
+	}
+	if (this->right_hand_columns > 1 && !this->initial_guess_file.empty())
+	{
+		throw std::invalid_argument("Several right-hand sides can't start from an initial approximation!");
+	}
+	if (this->right_hand_columns > 1 && (this->solver != JACOBI_SOLVER || this->kernel != PLAIN_KERNEL ||
+		!this->overlap_mode.empty() || this->partition != ROWS_PARTITION || this->use_grid || this->compare))
+	{
+		throw std::invalid_argument("Several right-hand sides are supported only by the plain "
+			+ JACOBI_SOLVER + " solver with the " + ROWS_PARTITION + " partition!");
+	}
+}
+
+void mpi_tester::print_process_id() const
+{
+	if (this->verbose)
+	{
+		std::cout << "[" << this->process_id << "] ";
+	}
+}
+
+void mpi_tester::init()
+{
+	MPI_Comm_size(MPI_COMM_WORLD, &this->total_processes);
+	MPI_Comm_rank(MPI_COMM_WORLD, &this->process_id);
+	this->trace->start(MPI_COMM_WORLD);
+
+	if (this->use_grid)
+	{
+		this->init_grid();
+		return;
+	}
+
+	if (this->sparse)
+	{
+		this->init_sparse();
+	}
+	else if (this->use_gen_input)
+	{
+		// Every process knows the size from its own arguments, so there is nothing to send
+		this->calculate_data_distribution();
+		this->generate_initial_data();
+	}
+	else if (this->process_id == this->ROOT_ID)
+	{
+		log("Reading matrix and approximation");
+		this->read_matrix();
+		this->approximation = std::make_shared<m_vector>(this->matrix_rows);
+		this->approximation_block = std::make_shared<m_matrix>(this->matrix_rows, this->right_hand_columns);
+		this->calculate_data_distribution();
+		this->check_range();
+		this->send_meta_data();
+		this->check_right_hand_columns();
+		this->send_initial_data();
+	}
+	else
+	{
+		this->receive_meta_data();
+		this->calculate_data_distribution();
+		this->check_right_hand_columns();
+		this->receive_initial_data();
+	}
+
+	if (!this->sparse && this->partition != ROWS_PARTITION)
+	{
+		this->rebalance();
+	}
+
+	// Loaded last, so that it follows the final distribution of rows
+	if (!this->initial_guess_file.empty())
+	{
+		this->load_initial_guess();
+	}
+}
+
+m_vector::vector_t mpi_tester::read_initial_guess() const
+{
+	auto binary = this->initial_guess_format == BINARY_FORMAT;
+	std::ifstream input_file(this->initial_guess_file, binary ? std::ifstream::binary : std::ifstream::in);
+
+	if (!input_file)
+	{
+		throw std::runtime_error("Initial approximation file does not exist or not ready to read: "
+			+ this->initial_guess_file);
+	}
+
+	input_file.exceptions(std::ifstream::badbit | std::ifstream::failbit);
+
+	if (!binary)
+	{
+		// The format print_answer writes: the size followed by the values
+		size_t n;
+		input_file >> n;
+		auto result = std::make_shared<m_vector>(n);
+		input_file >> *result;
+		return result;
+	}
+
+	// Unsigned 64-bit size followed by that many doubles, in native byte order
+	unsigned long long n;
+	input_file.read(reinterpret_cast<char *>(&n), sizeof(n));
+	std::vector<double> values(static_cast<size_t>(n));
+	input_file.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(double));
+
+	auto result = std::make_shared<m_vector>(values.size());
+	std::copy(values.begin(), values.end(), result->get_data()->begin());
+	return result;
+}
+
+void mpi_tester::load_initial_guess()
+{
+	log("Loading initial approximation");
+
+	m_vector::vector_t full;
+	long size = 0;
+
+	if (this->process_id == this->ROOT_ID)
+	{
+		full = this->read_initial_guess();
+		size = static_cast<long>(full->get_size());
+	}
+
+	MPI_Bcast(&size, 1, MPI_LONG, this->ROOT_ID, MPI_COMM_WORLD);
+
+	if (static_cast<size_t>(size) != this->get_size())
+	{
+		std::stringstream ss;
+		ss << "Initial approximation has " << size << " values, but the system has " << this->get_size() << " unknowns!";
+		throw std::invalid_argument(ss.str());
+	}
+
+	auto rows = (*this->rows_number_distribution)[this->process_id];
+	this->initial_guess = std::make_shared<m_vector>(rows);
+
+	MPI_Scatterv(full ? full->get_data()->data() : nullptr,
+	             this->rows_number_distribution->data(),
+	             this->rows_positions_distribution->data(), mpi_type_t,
+	             this->initial_guess->get_data()->data(), rows, mpi_type_t,
+	             this->ROOT_ID, MPI_COMM_WORLD);
+}
+
+const m_vector &mpi_tester::get_initial_guess() const
+{
+	// Without a loaded approximation every solver starts from x0 = b
+	return this->initial_guess && !this->cold_run ? *this->initial_guess : *this->right_hand_side;
+}
+
+void mpi_tester::generate_initial_data()
+{
+	log("Generating local stripe of matrix and right-hand side");
+	m_trace::scope region(*this->trace, "generate");
+
+	auto rows = static_cast<size_t>((*this->rows_number_distribution)[this->process_id]);
+	auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+	auto generator = m_generator::create(this->generator_family, this->get_size(),
+	                                     this->generator_bandwidth, this->generator_seed);
+
+	this->coeff_matrix = generator->generate_rows(first_row, rows);
+	this->right_hand_side = generator->generate_right_hand(first_row, rows);
+	// The shared iterates live in the node window, so only the root needs the whole approximation there
+	this->approximation = std::make_shared<m_vector>(this->use_shared && this->process_id != this->ROOT_ID
+		                                                 ? rows
+		                                                 : this->get_size());
+}
+
+void mpi_tester::init_sparse()
+{
+	if (this->use_gen_input)
+	{
+		this->calculate_data_distribution();
+
+		log("Generating local stripe of sparse matrix and right-hand side");
+
+		auto rows = static_cast<size_t>((*this->rows_number_distribution)[this->process_id]);
+		auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+		auto generator = m_generator::create(this->generator_family, this->get_size(),
+		                                     this->generator_bandwidth, this->generator_seed);
+
+		this->sparse_matrix = generator->generate_sparse_rows(first_row, rows);
+		this->right_hand_side = generator->generate_right_hand(first_row, rows);
+	}
+	else
+	{
+		this->load_sparse_matrix();
+	}
+
+	if (this->partition != ROWS_PARTITION)
+	{
+		this->rebalance();
+	}
+
+	auto rows = static_cast<size_t>((*this->rows_number_distribution)[this->process_id]);
+	auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+
+	this->halo = std::make_shared<m_halo>(*this->sparse_matrix, first_row,
+	                                      *this->rows_positions_distribution, MPI_COMM_WORLD);
+	// Only the root keeps the whole approximation, the others hold just their rows
+	this->approximation = std::make_shared<m_vector>(this->process_id == this->ROOT_ID ? this->get_size() : rows);
+
+	std::stringstream ss;
+	ss << "Non-zeros: " << this->sparse_matrix->get_nonzeros()
+		<< ", halo: " << this->halo->get_halo_size() << " values from " << this->halo->get_recv_neighbours() << " processes"
+		<< ", sending " << this->halo->get_send_size() << " values to " << this->halo->get_send_neighbours() << " processes";
+	auto msg = ss.str();
+	log(msg);
+}
+
+void mpi_tester::init_grid()
+{
+	if (!this->use_gen_input)
+	{
+		if (this->process_id == this->ROOT_ID)
+		{
+			log("Reading matrix and approximation");
+			this->read_matrix();
+			this->send_meta_data();
+		}
+		else
+		{
+			this->receive_meta_data();
+		}
+		this->check_right_hand_columns();
+	}
+
+	this->grid = std::make_shared<m_process_grid>(this->get_size(), this->grid_block, MPI_COMM_WORLD);
+
+	auto row_indices = this->grid->indices(this->grid->get_row());
+	auto column_indices = this->grid->indices(this->grid->get_column());
+	auto block = std::make_shared<m_matrix>(row_indices.size(), column_indices.size());
+	// The right-hand side of a row group lives on its diagonal process only
+	auto right_hand = std::make_shared<m_vector>(this->grid->is_diagonal() ? row_indices.size() : 0);
+
+	if (this->use_gen_input)
+	{
+		log("Generating local block of matrix and right-hand side");
+
+		auto generator = m_generator::create(this->generator_family, this->get_size(),
+		                                     this->generator_bandwidth, this->generator_seed);
+
+		for (size_t k = 0; k < row_indices.size(); ++k)
+		{
+			for (size_t l = 0; l < column_indices.size(); ++l)
+			{
+				(*block)[k][l] = generator->coefficient(row_indices[k], column_indices[l]);
+			}
+			if (this->grid->is_diagonal())
+			{
+				(*right_hand)[k] = generator->right_hand(row_indices[k]);
+			}
+		}
+	}
+	else
+	{
+		log("Scattering matrix blocks");
+
+		auto dimension = this->grid->get_dimension();
+		std::vector<int> cells(this->total_processes, 0), cells_positions(this->total_processes, 0);
+		std::vector<int> values(this->total_processes, 0), values_positions(this->total_processes, 0);
+		std::vector<type_t> plain_cells, plain_values;
+
+		if (this->process_id == this->ROOT_ID)
+		{
+			for (auto p = 0; p < this->total_processes; ++p)
+			{
+				auto p_rows = this->grid->indices(p / dimension);
+				auto p_columns = this->grid->indices(p % dimension);
+				cells_positions[p] = static_cast<int>(plain_cells.size());
+				values_positions[p] = static_cast<int>(plain_values.size());
+
+				for (auto i : p_rows)
+				{
+					for (auto j : p_columns)
+					{
+						plain_cells.push_back((*this->coeff_matrix)[i][j]);
+					}
+					if (p / dimension == p % dimension)
+					{
+						plain_values.push_back((*this->right_hand_side)[i]);
+					}
+				}
+				cells[p] = static_cast<int>(plain_cells.size()) - cells_positions[p];
+				values[p] = static_cast<int>(plain_values.size()) - values_positions[p];
+			}
+		}
+
+		auto local_cells = std::make_shared<std::vector<type_t>>(row_indices.size() * column_indices.size());
+		MPI_Scatterv(plain_cells.data(), cells.data(), cells_positions.data(), mpi_type_t,
+		             local_cells->data(), static_cast<int>(local_cells->size()), mpi_type_t,
+		             this->ROOT_ID, MPI_COMM_WORLD);
+		MPI_Scatterv(plain_values.data(), values.data(), values_positions.data(), mpi_type_t,
+		             right_hand->get_data()->data(), static_cast<int>(right_hand->get_size()), mpi_type_t,
+		             this->ROOT_ID, MPI_COMM_WORLD);
+
+		block->fill(local_cells, local_cells->size());
+	}
+
+	this->coeff_matrix = block;
+	this->right_hand_side = right_hand;
+	this->approximation = std::make_shared<m_vector>(this->process_id == this->ROOT_ID ? this->get_size() : 0);
+
+	std::stringstream ss;
+	ss << "Grid position: (" << this->grid->get_row() << ", " << this->grid->get_column() << ") of "
+		<< this->grid->get_dimension() << "x" << this->grid->get_dimension()
+		<< ", block: " << row_indices.size() << "x" << column_indices.size();
+	auto msg = ss.str();
+	log(msg);
+}
+
+void mpi_tester::load_sparse_matrix()
+{
+	std::vector<unsigned long long> row_indices;
+	std::vector<unsigned long long> column_indices;
+	std::vector<type_t> values;
+	std::vector<type_t> right_hand;
+
+	if (this->process_id == this->ROOT_ID)
+	{
+		log("Reading sparse matrix");
+
+		std::ifstream input_file(this->input_file_matrix);
+
+		if (!input_file)
+		{
+			throw std::runtime_error("Input file does not exist or not ready to read: " + this->input_file_matrix);
+		}
+
+		input_file.exceptions(std::ifstream::badbit | std::ifstream::failbit);
+
+		// Coordinate format: "n nonzeros", then "row column value" per non-zero (0-based), then n right-hand values
+		size_t n, nonzeros;
+		input_file >> n >> nonzeros;
+
+		row_indices.resize(nonzeros);
+		column_indices.resize(nonzeros);
+		values.resize(nonzeros);
+		right_hand.resize(n);
+
+		for (size_t k = 0; k < nonzeros; ++k)
+		{
+			input_file >> row_indices[k] >> column_indices[k] >> values[k];
+			if (row_indices[k] >= n || column_indices[k] >= n)
+			{
+				std::stringstream ss;
+				ss << "Non-zero " << k << " at (" << row_indices[k] << ", " << column_indices[k]
+					<< ") lies outside of the " << n << "x" << n << " matrix!";
+				throw std::range_error(ss.str());
+			}
+		}
+		for (size_t i = 0; i < n; ++i)
+		{
+			input_file >> right_hand[i];
+		}
+
+		input_file.close();
+
+		this->matrix_rows = n;
+		this->matrix_columns = n + 1;
+		this->calculate_data_distribution();
+		this->send_meta_data();
+	}
+	else
+	{
+		this->receive_meta_data();
+		this->calculate_data_distribution();
+	}
+
+	auto rows = (*this->rows_number_distribution)[this->process_id];
+	auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+	std::vector<int> counts(this->total_processes, 0);
+	std::vector<int> displs(this->total_processes, 0);
+	std::vector<unsigned long long> owner_rows, owner_columns;
+	std::vector<type_t> owner_values;
+
+	if (this->process_id == this->ROOT_ID)
+	{
+		// Group the non-zeros by the process owning their row
+		std::vector<int> owners(values.size());
+		for (size_t k = 0; k < values.size(); ++k)
+		{
+			owners[k] = static_cast<int>(std::upper_bound(this->rows_positions_distribution->begin(),
+			                                              this->rows_positions_distribution->end(),
+			                                              static_cast<int>(row_indices[k]))
+				- this->rows_positions_distribution->begin() - 1);
+			counts[owners[k]]++;
+		}
+		for (auto p = 1; p < this->total_processes; ++p)
+		{
+			displs[p] = displs[p - 1] + counts[p - 1];
+		}
+
+		auto next = displs;
+		owner_rows.resize(values.size());
+		owner_columns.resize(values.size());
+		owner_values.resize(values.size());
+		for (size_t k = 0; k < values.size(); ++k)
+		{
+			auto position = next[owners[k]]++;
+			owner_rows[position] = row_indices[k];
+			owner_columns[position] = column_indices[k];
+			owner_values[position] = values[k];
+		}
+	}
+
+	auto local_count = 0;
+	MPI_Scatter(counts.data(), 1, MPI_INT, &local_count, 1, MPI_INT, this->ROOT_ID, MPI_COMM_WORLD);
+
+	std::vector<unsigned long long> local_rows(local_count), local_columns(local_count);
+	std::vector<type_t> local_values(local_count);
+
+	MPI_Scatterv(owner_rows.data(), counts.data(), displs.data(), MPI_UNSIGNED_LONG_LONG,
+	             local_rows.data(), local_count, MPI_UNSIGNED_LONG_LONG, this->ROOT_ID, MPI_COMM_WORLD);
+	MPI_Scatterv(owner_columns.data(), counts.data(), displs.data(), MPI_UNSIGNED_LONG_LONG,
+	             local_columns.data(), local_count, MPI_UNSIGNED_LONG_LONG, this->ROOT_ID, MPI_COMM_WORLD);
+	MPI_Scatterv(owner_values.data(), counts.data(), displs.data(), mpi_type_t,
+	             local_values.data(), local_count, mpi_type_t, this->ROOT_ID, MPI_COMM_WORLD);
+
+	this->right_hand_side = std::make_shared<m_vector>(rows);
+	MPI_Scatterv(right_hand.data(), this->rows_number_distribution->data(),
+	             this->rows_positions_distribution->data(), mpi_type_t,
+	             this->right_hand_side->get_data()->data(), rows, mpi_type_t, this->ROOT_ID, MPI_COMM_WORLD);
+
+	this->sparse_matrix = m_csr_matrix::from_triplets(rows, first_row, local_rows, local_columns, local_values);
+}
+
+std::string mpi_tester::get_metadata() const
+{
+	std::stringstream ss;
+	ss << "n: " << this->get_size()
+		<< ", precision: " << this->precision
+		<< ", max_iterations: " << this->max_iterations
+		<< ", right_hand_columns: " << this->right_hand_columns
 		<< ", rows_per_process: " << this->rows_per_process
 		<< ", cells_per_process: " << this->cells_per_process;
 	return ss.str();
@@ -340,10 +1449,12 @@ void mpi_tester::send_meta_data() const
 	auto size = static_cast<long>(this->get_size());
 	auto precision = this->precision;
 	auto max_iterations = static_cast<long>(this->max_iterations);
+	auto right_hand_columns = static_cast<long>(this->right_hand_columns);
 
 	MPI_Bcast(&size, 1, MPI_LONG, this->ROOT_ID, MPI_COMM_WORLD);
 	MPI_Bcast(&precision, 1, MPI_DOUBLE, this->ROOT_ID, MPI_COMM_WORLD);
 	MPI_Bcast(&max_iterations, 1, MPI_LONG, this->ROOT_ID, MPI_COMM_WORLD);
+	MPI_Bcast(&right_hand_columns, 1, MPI_LONG, this->ROOT_ID, MPI_COMM_WORLD);
 }
 
 void mpi_tester::receive_meta_data()
@@ -353,13 +1464,16 @@ void mpi_tester::receive_meta_data()
 	long size = 0;
 	auto precision = 0.0;
 	auto max_iterations = static_cast<long>(this->max_iterations);
+	long right_hand_columns = 1;
 
 	MPI_Bcast(&size, 1, MPI_LONG, this->ROOT_ID, MPI_COMM_WORLD);
 	MPI_Bcast(&precision, 1, MPI_DOUBLE, this->ROOT_ID, MPI_COMM_WORLD);
 	MPI_Bcast(&max_iterations, 1, MPI_LONG, this->ROOT_ID, MPI_COMM_WORLD);
+	MPI_Bcast(&right_hand_columns, 1, MPI_LONG, this->ROOT_ID, MPI_COMM_WORLD);
 
 	this->matrix_rows = static_cast<size_t>(size);
-	this->matrix_columns = matrix_rows + 1;
+	this->right_hand_columns = static_cast<size_t>(right_hand_columns);
+	this->matrix_columns = matrix_rows + this->right_hand_columns;
 	this->precision = precision;
 	this->max_iterations = max_iterations;
 }
@@ -373,16 +1487,37 @@ void mpi_tester::send_initial_data() const
 
 	auto plain_matrix_data = std::make_shared<std::vector<type_t>>(cells);
 	auto plain_right_hand_data = std::make_shared<std::vector<type_t>>(rows);
+	m_trace::scope region(*this->trace, "MPI_Scatterv", (cells + rows) * sizeof(type_t));
 
 	MPI_Scatterv(this->coeff_matrix->get_plain_data()->data(),
 	             this->cells_number_distribution->data(),
-	             this->cells_positions_distribution->data(), MPI_DOUBLE,
-	             plain_matrix_data->data(), static_cast<int>(cells), MPI_DOUBLE,
+	             this->cells_positions_distribution->data(), mpi_type_t,
+	             plain_matrix_data->data(), static_cast<int>(cells), mpi_type_t,
 	             this->ROOT_ID, MPI_COMM_WORLD);
+
+	if (this->right_hand_columns > 1)
+	{
+		auto k = static_cast<int>(this->right_hand_columns);
+		std::vector<int> block_number(this->total_processes), block_positions(this->total_processes);
+		for (auto i = 0; i < this->total_processes; ++i)
+		{
+			block_number[i] = (*this->rows_number_distribution)[i] * k;
+			block_positions[i] = (*this->rows_positions_distribution)[i] * k;
+		}
+
+		// The root keeps its whole block, the received copy is not needed
+		std::vector<type_t> plain_block_data(rows * k);
+		MPI_Scatterv(this->right_hand_block->get_plain_data()->data(),
+		             block_number.data(), block_positions.data(), mpi_type_t,
+		             plain_block_data.data(), rows * k, mpi_type_t,
+		             this->ROOT_ID, MPI_COMM_WORLD);
+		return;
+	}
+
 	MPI_Scatterv(this->right_hand_side->get_data()->data(),
 	             this->rows_number_distribution->data(),
-	             this->rows_positions_distribution->data(), MPI_DOUBLE,
-	             plain_right_hand_data->data(), static_cast<int>(rows), MPI_DOUBLE,
+	             this->rows_positions_distribution->data(), mpi_type_t,
+	             plain_right_hand_data->data(), static_cast<int>(rows), mpi_type_t,
 	             this->ROOT_ID, MPI_COMM_WORLD);
 }
 
@@ -395,63 +1530,1808 @@ void mpi_tester::receive_initial_data()
 
 	this->coeff_matrix = std::make_shared<m_matrix>(rows, this->get_size());
 	this->right_hand_side = std::make_shared<m_vector>(rows);
-	this->approximation = std::make_shared<m_vector>(this->matrix_rows);
+	this->approximation = std::make_shared<m_vector>(this->use_shared ? rows : this->matrix_rows);
 
 	auto plain_matrix_data = std::make_shared<std::vector<type_t>>(cells);
 	auto plain_right_hand_data = std::make_shared<std::vector<type_t>>(rows);
+	m_trace::scope region(*this->trace, "MPI_Scatterv", (cells + rows) * sizeof(type_t));
 
 	MPI_Scatterv(nullptr,
 	             this->cells_number_distribution->data(),
-	             this->cells_positions_distribution->data(), MPI_DOUBLE,
-	             plain_matrix_data->data(), cells, MPI_DOUBLE,
-	             this->ROOT_ID, MPI_COMM_WORLD);
-	MPI_Scatterv(nullptr,
-	             this->rows_number_distribution->data(),
-	             this->rows_positions_distribution->data(), MPI_DOUBLE,
-	             plain_right_hand_data->data(), rows, MPI_DOUBLE,
+	             this->cells_positions_distribution->data(), mpi_type_t,
+	             plain_matrix_data->data(), cells, mpi_type_t,
 	             this->ROOT_ID, MPI_COMM_WORLD);
-
 	this->coeff_matrix->fill(plain_matrix_data, cells);
-	this->right_hand_side->fill(plain_right_hand_data, rows);
+
+	if (this->right_hand_columns > 1)
+	{
+		auto k = static_cast<int>(this->right_hand_columns);
+		std::vector<int> block_number(this->total_processes), block_positions(this->total_processes);
+		for (auto i = 0; i < this->total_processes; ++i)
+		{
+			block_number[i] = (*this->rows_number_distribution)[i] * k;
+			block_positions[i] = (*this->rows_positions_distribution)[i] * k;
+		}
+
+		auto plain_block_data = std::make_shared<std::vector<type_t>>(rows * k);
+		MPI_Scatterv(nullptr, block_number.data(), block_positions.data(), mpi_type_t,
+		             plain_block_data->data(), rows * k, mpi_type_t,
+		             this->ROOT_ID, MPI_COMM_WORLD);
+
+		this->right_hand_block = std::make_shared<m_matrix>(rows, this->right_hand_columns);
+		this->right_hand_block->fill(plain_block_data, plain_block_data->size());
+		this->approximation_block = std::make_shared<m_matrix>(rows, this->right_hand_columns);
+		return;
+	}
+
+	MPI_Scatterv(nullptr,
+	             this->rows_number_distribution->data(),
+	             this->rows_positions_distribution->data(), mpi_type_t,
+	             plain_right_hand_data->data(), rows, mpi_type_t,
+	             this->ROOT_ID, MPI_COMM_WORLD);
+
+	this->right_hand_side->fill(plain_right_hand_data, rows);
+}
+
+type_t mpi_tester::row_update(const size_t row, const m_vector &x) const
+{
+	auto g = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]) + row;
+	auto &coefficients = (*this->coeff_matrix)[row];
+	auto result = (*this->right_hand_side)[row];
+
+	for (size_t j = 0; j < g; ++j)
+		result -= coefficients[j] * x[j];
+	for (auto j = g + 1; j < this->get_size(); ++j)
+		result -= coefficients[j] * x[j];
+
+	return result / coefficients[g];
+}
+
+double mpi_tester::estimate_jacobi_radius(const size_t iterations) const
+{
+	auto x_old = std::make_shared<m_vector>(this->get_size());
+	auto x_new = std::make_shared<m_vector>(this->get_size());
+	auto rows = (*this->rows_number_distribution)[this->process_id];
+	auto first_row = (*this->rows_positions_distribution)[this->process_id];
+
+	MPI_Allgatherv(this->right_hand_side->get_data()->data(), rows, mpi_type_t,
+	               x_new->get_data()->data(), this->rows_number_distribution->data(),
+	               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+
+	// The ratio of successive corrections tends to the spectral radius of the Jacobi iteration matrix
+	auto previous = 0.0;
+	auto ratio = 0.0;
+
+	for (size_t k = 0; k < iterations; ++k)
+	{
+		x_old.swap(x_new);
+
+		auto local_part = 0.0;
+		for (auto i = 0; i < rows; ++i)
+		{
+			(*this->approximation)[i] = this->row_update(i, *x_old);
+			this->accumulate_norm(local_part, (*this->approximation)[i] - (*x_old)[first_row + i]);
+		}
+
+		MPI_Allgatherv(this->approximation->get_data()->data(), rows, mpi_type_t,
+		               x_new->get_data()->data(), this->rows_number_distribution->data(),
+		               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+
+		auto current = this->reduce_norm(local_part);
+		if (current == 0.0)
+		{
+			break;
+		}
+		if (previous > 0.0)
+		{
+			ratio = current / previous;
+		}
+		previous = current;
+	}
+
+	return ratio;
+}
+
+std::pair<bool, size_t> mpi_tester::solve(const std::string &name) const
+{
+	if (name == GAUSS_SEIDEL_SOLVER)
+	{
+		return this->apply_gauss_seidel(false, 1.0);
+	}
+	if (name == RED_BLACK_SOLVER)
+	{
+		return this->apply_gauss_seidel(true, 1.0);
+	}
+	if (name == SOR_SOLVER)
+	{
+		return this->apply_sor();
+	}
+	if (name == CG_SOLVER)
+	{
+		return this->apply_conjugate_gradient();
+	}
+	if (name == GMRES_SOLVER)
+	{
+		return this->apply_gmres();
+	}
+	if (name == BLOCK_JACOBI_SOLVER)
+	{
+		return this->apply_block_jacobi();
+	}
+	if (this->use_grid)
+	{
+		return this->apply_grid_jacobi();
+	}
+	if (this->right_hand_columns > 1)
+	{
+		return this->apply_batched_jacobi();
+	}
+	if (this->acceleration == CHEBYSHEV_ACCELERATION)
+	{
+		return this->apply_chebyshev_jacobi();
+	}
+	if (this->acceleration == ANDERSON_ACCELERATION)
+	{
+		return this->apply_anderson_jacobi();
+	}
+	if (this->use_shared)
+	{
+		return this->apply_shared_jacobi();
+	}
+	if (this->sparse)
+	{
+		return this->apply_sparse_jacobi();
+	}
+	if (this->kernel == SIMD_KERNEL)
+	{
+		return this->apply_simd_jacobi();
+	}
+
+	return this->overlap_mode.empty() ? this->apply_jacobi() : this->apply_pipelined_jacobi();
+}
+
+std::pair<bool, size_t> mpi_tester::run_solver(const std::string &name) const
+{
+	auto before = MPI_Wtime();
+	auto result = this->solve(name);
+	auto time = MPI_Wtime() - before;
+	this->trace->set_iteration(0);
+
+	if (this->process_id == this->ROOT_ID)
+	{
+		std::cout << "Solver: " << name
+			<< ", converged: " << (result.first ? "true" : "false")
+			<< ", iterations: " << result.second
+			<< ", time: " << time * 1000 << "ms" << std::endl;
+	}
+
+	return result;
+}
+
+std::pair<bool, size_t> mpi_tester::apply_gauss_seidel(const bool red_black, const double relaxation) const
+{
+	auto x = std::make_shared<m_vector>(this->get_size());
+	auto rows = (*this->rows_number_distribution)[this->process_id];
+	auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+	auto use_residual = this->stop_criterion == RESIDUAL_CRITERION;
+	auto colors = red_black ? 2 : 1;
+
+	MPI_Allgatherv(this->get_initial_guess().get_data()->data(), rows, mpi_type_t,
+	               x->get_data()->data(), this->rows_number_distribution->data(),
+	               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+
+	for (auto i = 0; i < rows; ++i)
+	{
+		(*this->approximation)[i] = (*x)[first_row + i];
+	}
+
+	auto right_hand_norm = this->get_right_hand_norm();
+	size_t iteration = 0;
+	auto converged = false;
+
+	do
+	{
+		iteration++;
+		this->trace->set_iteration(iteration);
+
+		auto check = this->is_check_iteration(iteration);
+		auto local_part = 0.0;
+
+		for (auto color = 0; color < colors; ++color)
+		{
+			{
+				m_trace::scope region(*this->trace, "rows");
+				for (auto i = 0; i < rows; ++i)
+				{
+					auto g = first_row + i;
+					if (red_black && static_cast<int>(g % 2) != color)
+					{
+						continue;
+					}
+
+					// Block Gauss-Seidel: own rows see the values already updated in this sweep,
+					// rows of other processes are taken from the last gather.
+					// Red-black rows of one color are updated from the same snapshot.
+					auto update = this->row_update(i, *x);
+					auto value = (1 - relaxation) * (*x)[g] + relaxation * update;
+
+					if (check)
+					{
+						// a[g][g] * (update - x[g]) is the residual of the row at the current iterate
+						this->accumulate_norm(local_part, use_residual
+							                                  ? (*this->coeff_matrix)[i][g] * (update - (*x)[g])
+							                                  : value - (*x)[g]);
+					}
+
+					(*this->approximation)[i] = value;
+					if (!red_black)
+					{
+						(*x)[g] = value;
+					}
+				}
+			}
+
+			{
+				m_trace::scope region(*this->trace, "MPI_Allgatherv", this->get_size() * sizeof(type_t));
+				MPI_Allgatherv(this->approximation->get_data()->data(), rows, mpi_type_t,
+				               x->get_data()->data(), this->rows_number_distribution->data(),
+				               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+			}
+		}
+
+		if (check)
+		{
+			auto residual = this->reduce_norm(local_part) / right_hand_norm;
+			this->trace->set_residual(residual);
+			converged = residual < this->precision;
+		}
+	}
+	while (iteration < this->max_iterations && !converged);
+
+	return std::make_pair(converged, iteration);
+}
+
+std::pair<bool, size_t> mpi_tester::apply_sor() const
+{
+	auto relaxation = this->omega;
+
+	if (this->auto_omega)
+	{
+		// Young's optimal factor from the spectral radius of the Jacobi iteration matrix
+		auto radius = this->estimate_jacobi_radius(RADIUS_ESTIMATION_ITERATIONS);
+		relaxation = radius < 1.0 ? 2.0 / (1.0 + std::sqrt(1.0 - radius * radius)) : 1.0;
+
+		if (this->process_id == this->ROOT_ID)
+		{
+			std::cout << "Estimated Jacobi spectral radius: " << radius
+				<< " after " << RADIUS_ESTIMATION_ITERATIONS << " iterations, omega: " << relaxation << std::endl;
+		}
+	}
+
+	return this->apply_gauss_seidel(false, relaxation);
+}
+
+void mpi_tester::multiply(const std::vector<type_t> &local, m_vector &full, std::vector<type_t> &result) const
+{
+	auto rows = (*this->rows_number_distribution)[this->process_id];
+
+	{
+		m_trace::scope region(*this->trace, "MPI_Allgatherv", this->get_size() * sizeof(type_t));
+		MPI_Allgatherv(local.data(), rows, mpi_type_t,
+		               full.get_data()->data(), this->rows_number_distribution->data(),
+		               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+	}
+
+	m_trace::scope region(*this->trace, "multiply");
+	auto x = full.get_data()->data();
+	for (auto i = 0; i < rows; ++i)
+	{
+		auto row = (*this->coeff_matrix)[i].get_data()->data();
+		type_t sum = 0;
+		for (size_t j = 0; j < this->get_size(); ++j)
+		{
+			sum += row[j] * x[j];
+		}
+		result[i] = sum;
+	}
+}
+
+void mpi_tester::precondition(const std::vector<type_t> &local, std::vector<type_t> &result) const
+{
+	auto first_row = (*this->rows_positions_distribution)[this->process_id];
+
+	for (size_t i = 0; i < local.size(); ++i)
+	{
+		result[i] = this->preconditioner == JACOBI_PRECONDITIONER
+			            ? local[i] / (*this->coeff_matrix)[i][first_row + i]
+			            : local[i];
+	}
+}
+
+std::vector<type_t> mpi_tester::reduce_sums(const std::vector<type_t> &local_sums) const
+{
+	m_trace::scope region(*this->trace, "MPI_Allreduce", local_sums.size() * sizeof(type_t));
+	std::vector<type_t> result(local_sums.size());
+
+	MPI_Allreduce(local_sums.data(), result.data(), static_cast<int>(local_sums.size()), mpi_type_t,
+	              MPI_SUM, MPI_COMM_WORLD);
+
+	return result;
+}
+
+std::pair<bool, size_t> mpi_tester::apply_conjugate_gradient() const
+{
+	auto rows = static_cast<size_t>((*this->rows_number_distribution)[this->process_id]);
+	auto full = std::make_shared<m_vector>(this->get_size());
+	auto &b = *this->right_hand_side->get_data();
+	auto &x0 = *this->get_initial_guess().get_data();
+	std::vector<type_t> x(x0.begin(), x0.begin() + rows);
+	std::vector<type_t> r(rows), z(rows), p(rows), q(rows);
+
+	// Same starting point as the stationary methods
+	this->multiply(x, *full, q);
+	for (size_t i = 0; i < rows; ++i)
+	{
+		r[i] = b[i] - q[i];
+	}
+	this->precondition(r, z);
+	p = z;
+
+	std::vector<type_t> local_sums(3, 0);
+	for (size_t i = 0; i < rows; ++i)
+	{
+		local_sums[0] += b[i] * b[i];
+		local_sums[1] += r[i] * r[i];
+		local_sums[2] += r[i] * z[i];
+	}
+	auto sums = this->reduce_sums(local_sums);
+	auto right_hand_norm = sums[0] > 0 ? std::sqrt(static_cast<double>(sums[0])) : 1.0;
+	auto residual_norm = std::sqrt(static_cast<double>(sums[1]));
+	auto rz = sums[2];
+
+	size_t iteration = 0;
+	auto converged = residual_norm / right_hand_norm < this->precision;
+
+	while (!converged && iteration < this->max_iterations)
+	{
+		iteration++;
+		this->trace->set_iteration(iteration);
+
+		this->multiply(p, *full, q);
+		std::vector<type_t> local_pq(1, 0);
+		for (size_t i = 0; i < rows; ++i)
+		{
+			local_pq[0] += p[i] * q[i];
+		}
+		auto alpha = rz / this->reduce_sums(local_pq)[0];
+
+		for (size_t i = 0; i < rows; ++i)
+		{
+			x[i] += alpha * p[i];
+			r[i] -= alpha * q[i];
+		}
+		this->precondition(r, z);
+
+		// Both scalars of the step travel in one reduction
+		std::vector<type_t> local_step(2, 0);
+		for (size_t i = 0; i < rows; ++i)
+		{
+			local_step[0] += r[i] * r[i];
+			local_step[1] += r[i] * z[i];
+		}
+		auto step = this->reduce_sums(local_step);
+		residual_norm = std::sqrt(static_cast<double>(step[0]));
+		this->trace->set_residual(residual_norm / right_hand_norm);
+		converged = residual_norm / right_hand_norm < this->precision;
+
+		auto beta = step[1] / rz;
+		rz = step[1];
+		for (size_t i = 0; i < rows; ++i)
+		{
+			p[i] = z[i] + beta * p[i];
+		}
+	}
+
+	std::copy(x.begin(), x.end(), this->approximation->get_data()->begin());
+
+	return std::make_pair(converged, iteration);
+}
+
+std::pair<bool, size_t> mpi_tester::apply_gmres() const
+{
+	auto rows = static_cast<size_t>((*this->rows_number_distribution)[this->process_id]);
+	auto m = this->restart;
+	auto full = std::make_shared<m_vector>(this->get_size());
+	auto &b = *this->right_hand_side->get_data();
+	auto &x0 = *this->get_initial_guess().get_data();
+	std::vector<type_t> x(x0.begin(), x0.begin() + rows);
+	std::vector<type_t> w(rows), z(rows);
+	std::vector<std::vector<type_t>> basis(m + 1, std::vector<type_t>(rows));
+	std::vector<std::vector<type_t>> hessenberg(m + 1, std::vector<type_t>(m, 0));
+	std::vector<type_t> cs(m), sn(m), g(m + 1), y(m);
+
+	std::vector<type_t> local_b(1, 0);
+	for (size_t i = 0; i < rows; ++i)
+	{
+		local_b[0] += b[i] * b[i];
+	}
+	auto b_sum = this->reduce_sums(local_b)[0];
+	auto right_hand_norm = b_sum > 0 ? std::sqrt(static_cast<double>(b_sum)) : 1.0;
+
+	size_t iteration = 0;
+	auto converged = false;
+
+	while (!converged && iteration < this->max_iterations)
+	{
+		// Restart: r = b - A x
+		this->multiply(x, *full, w);
+		std::vector<type_t> local_r(1, 0);
+		for (size_t i = 0; i < rows; ++i)
+		{
+			w[i] = b[i] - w[i];
+			local_r[0] += w[i] * w[i];
+		}
+		auto beta = std::sqrt(this->reduce_sums(local_r)[0]);
+
+		if (beta / right_hand_norm < this->precision)
+		{
+			converged = true;
+			break;
+		}
+
+		for (size_t i = 0; i < rows; ++i)
+		{
+			basis[0][i] = w[i] / beta;
+		}
+		std::fill(g.begin(), g.end(), 0);
+		g[0] = beta;
+
+		size_t k = 0;
+		while (k < m && iteration < this->max_iterations && !converged)
+		{
+			iteration++;
+			this->trace->set_iteration(iteration);
+
+			// Right preconditioning keeps the true residual in the least-squares problem
+			this->precondition(basis[k], z);
+			this->multiply(z, *full, w);
+
+			// Classical Gram-Schmidt applied twice: every pass is a single reduction of k + 1 dot products
+			for (auto k_pass = 0; k_pass < 2; ++k_pass)
+			{
+				std::vector<type_t> local_h(k + 1, 0);
+				for (size_t j = 0; j <= k; ++j)
+				{
+					for (size_t i = 0; i < rows; ++i)
+					{
+						local_h[j] += basis[j][i] * w[i];
+					}
+				}
+				auto h = this->reduce_sums(local_h);
+				for (size_t j = 0; j <= k; ++j)
+				{
+					hessenberg[j][k] += h[j];
+					for (size_t i = 0; i < rows; ++i)
+					{
+						w[i] -= h[j] * basis[j][i];
+					}
+				}
+			}
+
+			std::vector<type_t> local_w(1, 0);
+			for (size_t i = 0; i < rows; ++i)
+			{
+				local_w[0] += w[i] * w[i];
+			}
+			auto w_norm = std::sqrt(this->reduce_sums(local_w)[0]);
+			hessenberg[k + 1][k] = w_norm;
+			for (size_t i = 0; i < rows; ++i)
+			{
+				basis[k + 1][i] = w_norm > 0 ? w[i] / w_norm : 0;
+			}
+
+			// Givens rotations turn the Hessenberg matrix into an upper triangular one
+			for (size_t j = 0; j < k; ++j)
+			{
+				auto temp = cs[j] * hessenberg[j][k] + sn[j] * hessenberg[j + 1][k];
+				hessenberg[j + 1][k] = -sn[j] * hessenberg[j][k] + cs[j] * hessenberg[j + 1][k];
+				hessenberg[j][k] = temp;
+			}
+			auto denominator = std::sqrt(hessenberg[k][k] * hessenberg[k][k] + hessenberg[k + 1][k] * hessenberg[k + 1][k]);
+			cs[k] = denominator > 0 ? hessenberg[k][k] / denominator : 1;
+			sn[k] = denominator > 0 ? hessenberg[k + 1][k] / denominator : 0;
+			hessenberg[k][k] = denominator;
+			hessenberg[k + 1][k] = 0;
+			g[k + 1] = -sn[k] * g[k];
+			g[k] = cs[k] * g[k];
+
+			this->trace->set_residual(std::fabs(static_cast<double>(g[k + 1])) / right_hand_norm);
+			converged = std::fabs(static_cast<double>(g[k + 1])) / right_hand_norm < this->precision;
+			k++;
+		}
+
+		// Back substitution for y and the update x += M^-1 V y
+		for (auto j = static_cast<long long>(k) - 1; j >= 0; --j)
+		{
+			y[j] = g[j];
+			for (auto l = static_cast<size_t>(j) + 1; l < k; ++l)
+			{
+				y[j] -= hessenberg[j][l] * y[l];
+			}
+			y[j] /= hessenberg[j][j];
+		}
+		std::fill(w.begin(), w.end(), 0);
+		for (size_t j = 0; j < k; ++j)
+		{
+			for (size_t i = 0; i < rows; ++i)
+			{
+				w[i] += y[j] * basis[j][i];
+			}
+		}
+		this->precondition(w, z);
+		for (size_t i = 0; i < rows; ++i)
+		{
+			x[i] += z[i];
+		}
+		for (auto &column : hessenberg)
+		{
+			std::fill(column.begin(), column.end(), 0);
+		}
+	}
+
+	std::copy(x.begin(), x.end(), this->approximation->get_data()->begin());
+
+	return std::make_pair(converged, iteration);
+}
+
+std::pair<bool, size_t> mpi_tester::apply_block_jacobi() const
+{
+	auto size = this->get_size();
+	auto rows = static_cast<size_t>((*this->rows_number_distribution)[this->process_id]);
+	auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+	auto last_row = first_row + rows;
+	auto use_residual = this->stop_criterion == RESIDUAL_CRITERION;
+
+	auto x_old = std::make_shared<m_vector>(size);
+	auto x_new = std::make_shared<m_vector>(size);
+	std::vector<type_t> local(rows);
+
+	// Factored once, every iteration is then two triangular solves
+	auto before = MPI_Wtime();
+	std::shared_ptr<m_block_lu> factors;
+	{
+		m_trace::scope region(*this->trace, "factor");
+		factors = std::make_shared<m_block_lu>(*this->coeff_matrix, first_row, rows);
+	}
+
+	std::stringstream ss;
+	ss << "Diagonal block " << rows << "x" << rows << " factored in " << (MPI_Wtime() - before) * 1000 << "ms";
+	auto msg = ss.str();
+	log(msg);
+
+	MPI_Allgatherv(this->get_initial_guess().get_data()->data(), static_cast<int>(rows), mpi_type_t,
+	               x_new->get_data()->data(), this->rows_number_distribution->data(),
+	               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+
+	auto right_hand_norm = this->get_right_hand_norm();
+	size_t iteration = 0;
+	auto converged = false;
+
+	do
+	{
+		iteration++;
+		this->trace->set_iteration(iteration);
+		x_old.swap(x_new);
+
+		auto check = this->is_check_iteration(iteration);
+		auto local_part = 0.0;
+
+		{
+			m_trace::scope region(*this->trace, "rows");
+
+			// Only the coupling to the other stripes comes from the gathered x
+			for (size_t i = 0; i < rows; ++i)
+			{
+				local[i] = (*this->right_hand_side)[i];
+			}
+			this->subtract_columns(local, *x_old, 0, 0, first_row);
+			this->subtract_columns(local, *x_old, 0, last_row, size);
+
+			if (check && use_residual)
+			{
+				for (size_t i = 0; i < rows; ++i)
+				{
+					auto residual = local[i];
+					auto &row = (*this->coeff_matrix)[i];
+					for (auto j = first_row; j < last_row; ++j)
+					{
+						residual -= row[j] * (*x_old)[j];
+					}
+					this->accumulate_norm(local_part, residual);
+				}
+			}
+
+			factors->solve(local);
+
+			for (size_t i = 0; i < rows; ++i)
+			{
+				(*this->approximation)[i] = local[i];
+				if (check && !use_residual)
+				{
+					this->accumulate_norm(local_part, local[i] - (*x_old)[first_row + i]);
+				}
+			}
+		}
+
+		{
+			m_trace::scope region(*this->trace, "MPI_Allgatherv", size * sizeof(type_t));
+			MPI_Allgatherv(this->approximation->get_data()->data(), static_cast<int>(rows), mpi_type_t,
+			               x_new->get_data()->data(), this->rows_number_distribution->data(),
+			               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+		}
+
+		if (check)
+		{
+			auto residual = this->reduce_norm(local_part) / right_hand_norm;
+			this->trace->set_residual(residual);
+			converged = residual < this->precision;
+		}
+	}
+	while (iteration < this->max_iterations && !converged);
+
+	return std::make_pair(converged, iteration);
+}
+
+std::pair<bool, size_t> mpi_tester::apply_sparse_jacobi() const
+{
+	auto rows = this->sparse_matrix->get_rows();
+	auto &row_starts = this->sparse_matrix->get_row_starts();
+	auto &columns = this->sparse_matrix->get_columns();
+	auto &values = this->sparse_matrix->get_values();
+	auto use_residual = this->stop_criterion == RESIDUAL_CRITERION;
+
+	// Own entries first, then the halo received from the neighbours
+	std::vector<type_t> x(rows + this->halo->get_halo_size());
+	std::vector<type_t> x_new(rows);
+	std::vector<type_t> diagonal(rows, 0);
+
+	for (size_t i = 0; i < rows; ++i)
+	{
+		for (auto k = row_starts[i]; k < row_starts[i + 1]; ++k)
+		{
+			if (columns[k] == i)
+			{
+				diagonal[i] += values[k];
+			}
+		}
+		if (diagonal[i] == 0)
+		{
+			std::stringstream ss;
+			ss << "Can't apply Jacobi method, row " << (*this->rows_positions_distribution)[this->process_id] + i
+				<< " has a zero diagonal element!";
+			throw std::runtime_error(ss.str());
+		}
+		x[i] = this->get_initial_guess()[i];
+	}
+
+	this->halo->exchange(x);
+
+	auto right_hand_norm = this->get_right_hand_norm();
+	size_t iteration = 0;
+	auto converged = false;
+
+	do
+	{
+		iteration++;
+		this->trace->set_iteration(iteration);
+
+		auto check = this->is_check_iteration(iteration);
+		auto local_part = 0.0;
+
+		{
+			m_trace::scope region(*this->trace, "rows");
+			for (size_t i = 0; i < rows; ++i)
+			{
+				auto sum = (*this->right_hand_side)[i];
+				for (auto k = row_starts[i]; k < row_starts[i + 1]; ++k)
+				{
+					if (columns[k] != i)
+					{
+						sum -= values[k] * x[columns[k]];
+					}
+				}
+				x_new[i] = sum / diagonal[i];
+
+				if (check)
+				{
+					auto delta = x_new[i] - x[i];
+					this->accumulate_norm(local_part, use_residual ? diagonal[i] * delta : delta);
+				}
+			}
+		}
+
+		std::copy(x_new.begin(), x_new.end(), x.begin());
+		{
+			m_trace::scope region(*this->trace, "halo exchange", this->halo->get_halo_size() * sizeof(type_t));
+			this->halo->exchange(x);
+		}
+
+		if (check)
+		{
+			auto residual = this->reduce_norm(local_part) / right_hand_norm;
+			this->trace->set_residual(residual);
+			converged = residual < this->precision;
+		}
+	}
+	while (iteration < this->max_iterations && !converged);
+
+	std::copy(x_new.begin(), x_new.end(), this->approximation->get_data()->begin());
+
+	return std::make_pair(converged, iteration);
 }
 
-std::pair<bool, size_t> mpi_tester::apply_jacobi() const
-{
+std::pair<bool, size_t> mpi_tester::apply_grid_jacobi() const
+{
+	auto row_indices = this->grid->indices(this->grid->get_row());
+	auto column_indices = this->grid->indices(this->grid->get_column());
+	auto rows = row_indices.size();
+	auto columns = column_indices.size();
+	auto diagonal = this->grid->is_diagonal();
+	auto use_residual = this->stop_criterion == RESIDUAL_CRITERION;
+
+	// x of the column group; on a diagonal process it is also the x of its row group
+	std::vector<type_t> x(columns);
+	std::vector<type_t> partial(rows);
+	std::vector<type_t> sums(rows);
+
+	auto right_hand_part = 0.0;
+	if (diagonal)
+	{
+		for (size_t k = 0; k < rows; ++k)
+		{
+			x[k] = (*this->right_hand_side)[k];
+			this->accumulate_norm(right_hand_part, (*this->right_hand_side)[k]);
+		}
+	}
+
+	MPI_Bcast(x.data(), static_cast<int>(columns), mpi_type_t, this->grid->get_column(), this->grid->get_column_comm());
+
+	auto right_hand_norm = 1.0;
+	if (use_residual)
+	{
+		right_hand_norm = this->reduce_norm(right_hand_part);
+		right_hand_norm = right_hand_norm == 0.0 ? 1.0 : right_hand_norm;
+	}
+
+	size_t iteration = 0;
+	auto converged = false;
+
+	do
+	{
+		iteration++;
+		this->trace->set_iteration(iteration);
+
+		auto check = this->is_check_iteration(iteration);
+		auto local_part = 0.0;
+
+		{
+			m_trace::scope region(*this->trace, "rows");
+			for (size_t k = 0; k < rows; ++k)
+			{
+				auto row = (*this->coeff_matrix)[k].get_data()->data();
+				type_t sum = 0;
+				for (size_t l = 0; l < columns; ++l)
+				{
+					sum += row[l] * x[l];
+				}
+				// The diagonal element sits at (k, k) of a diagonal block
+				partial[k] = diagonal ? sum - row[k] * x[k] : sum;
+			}
+		}
+
+		// Partial products meet on the diagonal process of the row group: O(n / sqrt(p)) values
+		{
+			m_trace::scope region(*this->trace, "MPI_Reduce", rows * sizeof(type_t));
+			MPI_Reduce(partial.data(), sums.data(), static_cast<int>(rows), mpi_type_t, MPI_SUM,
+			           this->grid->get_row(), this->grid->get_row_comm());
+		}
+
+		if (diagonal)
+		{
+			m_trace::scope region(*this->trace, "rows");
+			for (size_t k = 0; k < rows; ++k)
+			{
+				auto element = (*this->coeff_matrix)[k][k];
+				auto value = ((*this->right_hand_side)[k] - sums[k]) / element;
+				if (check)
+				{
+					this->accumulate_norm(local_part, use_residual ? element * (value - x[k]) : value - x[k]);
+				}
+				x[k] = value;
+			}
+		}
+
+		// ... and travel down the column group from there
+		{
+			m_trace::scope region(*this->trace, "MPI_Bcast", columns * sizeof(type_t));
+			MPI_Bcast(x.data(), static_cast<int>(columns), mpi_type_t, this->grid->get_column(),
+			          this->grid->get_column_comm());
+		}
+
+		if (check)
+		{
+			auto residual = this->reduce_norm(local_part) / right_hand_norm;
+			this->trace->set_residual(residual);
+			converged = residual < this->precision;
+		}
+	}
+	while (iteration < this->max_iterations && !converged);
+
+	// Diagonal processes hold the solution, one row group each
+	auto dimension = this->grid->get_dimension();
+	std::vector<int> counts(this->total_processes, 0), positions(this->total_processes, 0);
+	for (auto group = 0, position = 0; group < dimension; ++group)
+	{
+		auto p = group * dimension + group;
+		counts[p] = static_cast<int>(this->grid->indices(group).size());
+		positions[p] = position;
+		position += counts[p];
+	}
+
+	std::vector<type_t> gathered(this->process_id == this->ROOT_ID ? this->get_size() : 0);
+	{
+		m_trace::scope region(*this->trace, "MPI_Gatherv", diagonal ? rows * sizeof(type_t) : 0);
+		MPI_Gatherv(x.data(), diagonal ? static_cast<int>(rows) : 0, mpi_type_t,
+		            gathered.data(), counts.data(), positions.data(), mpi_type_t, this->ROOT_ID, MPI_COMM_WORLD);
+	}
+
+	if (this->process_id == this->ROOT_ID)
+	{
+		for (auto group = 0; group < dimension; ++group)
+		{
+			auto indices = this->grid->indices(group);
+			auto position = positions[group * dimension + group];
+			for (size_t k = 0; k < indices.size(); ++k)
+			{
+				(*this->approximation)[indices[k]] = gathered[position + k];
+			}
+		}
+	}
+
+	return std::make_pair(converged, iteration);
+}
+
+std::pair<bool, size_t> mpi_tester::apply_jacobi() const
+{
+	auto x_old = std::make_shared<m_vector>(this->get_size());
+	auto x_new = std::make_shared<m_vector>(this->get_size());
+
+	auto rows = (*this->rows_number_distribution)[this->process_id];
+	auto use_residual = this->stop_criterion == RESIDUAL_CRITERION;
+
+	MPI_Allgatherv(this->get_initial_guess().get_data()->data(), rows, mpi_type_t,
+	               x_new->get_data()->data(),
+	               this->rows_number_distribution->data(),
+	               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+
+	auto right_hand_norm = this->get_right_hand_norm();
+
+	size_t iteration = 0;
+	auto converged = false;
+
+	do
+	{
+		iteration++;
+		this->trace->set_iteration(iteration);
+		x_old.swap(x_new);
+
+		// Every process measures only its own rows, the parts are combined by one reduction
+		auto check = this->is_check_iteration(iteration);
+		auto local_part = 0.0;
+
+		{
+			m_trace::scope region(*this->trace, "rows");
+			for (auto i = 0; i < rows; ++i)
+			{
+				auto g = static_cast<size_t>(i + (*this->rows_positions_distribution)[this->process_id]);
+				(*approximation)[i] = (*this->right_hand_side)[i];
+				for (size_t j = 0; j < g; ++j)
+					(*approximation)[i] -= (*coeff_matrix)[i][j] * (*x_old)[j];
+				for (auto j = g + 1; j < this->get_size(); ++j)
+					(*approximation)[i] -= (*coeff_matrix)[i][j] * (*x_old)[j];
+				(*approximation)[i] /= (*coeff_matrix)[i][g];
+
+				if (check)
+				{
+					// a[g][g] * (x_new[g] - x_old[g]) is exactly the residual b - A * x_old of the row
+					auto delta = (*approximation)[i] - (*x_old)[g];
+					this->accumulate_norm(local_part, use_residual ? (*coeff_matrix)[i][g] * delta : delta);
+				}
+			}
+		}
+
+		{
+			m_trace::scope region(*this->trace, "MPI_Allgatherv", this->get_size() * sizeof(type_t));
+			MPI_Allgatherv(approximation->get_data()->data(), rows, mpi_type_t,
+			               x_new->get_data()->data(), this->rows_number_distribution->data(),
+			               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+		}
+
+		if (check)
+		{
+			auto residual = this->reduce_norm(local_part) / right_hand_norm;
+			this->trace->set_residual(residual);
+			converged = residual < this->precision;
+		}
+	}
+	while (iteration < this->max_iterations && !converged);
+
+	return std::make_pair(converged, iteration);
+}
+
+std::pair<bool, size_t> mpi_tester::apply_batched_jacobi() const
+{
+	auto size = this->get_size();
+	auto k = this->right_hand_columns;
+	auto rows = (*this->rows_number_distribution)[this->process_id];
+	auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+	auto use_residual = this->stop_criterion == RESIDUAL_CRITERION;
+
+	// Approximations are kept row-major with one slot per active right-hand side:
+	// x[j * width + c] is the unknown j of the right-hand side active[c]
+	std::vector<size_t> active(k);
+	std::vector<size_t> iterations(k, 0);
+	std::vector<type_t> x_old(size * k);
+	std::vector<type_t> x_new(size * k);
+	std::vector<type_t> local(rows * k);
+	std::vector<int> number(this->total_processes), positions(this->total_processes);
+	std::vector<double> right_hand_norms(k, 1.0);
+	std::vector<double> local_parts(k, 0.0);
+
+	for (size_t c = 0; c < k; ++c)
+	{
+		active[c] = c;
+	}
+	for (auto i = 0; i < rows; ++i)
+	{
+		for (size_t c = 0; c < k; ++c)
+		{
+			local[i * k + c] = (*this->right_hand_block)[i][c];
+			this->accumulate_norm(local_parts[c], local[i * k + c]);
+		}
+	}
+
+	if (use_residual)
+	{
+		right_hand_norms = this->reduce_norms(local_parts);
+		for (auto &value : right_hand_norms)
+		{
+			value = value == 0.0 ? 1.0 : value;
+		}
+	}
+
+	size_t iteration = 0;
+	size_t width = k;
+
+	auto gather = [&]()
+	{
+		for (auto i = 0; i < this->total_processes; ++i)
+		{
+			number[i] = (*this->rows_number_distribution)[i] * static_cast<int>(width);
+			positions[i] = (*this->rows_positions_distribution)[i] * static_cast<int>(width);
+		}
+
+		// Only the right-hand sides still being iterated travel, packed into one message
+		m_trace::scope region(*this->trace, "MPI_Allgatherv", size * width * sizeof(type_t));
+		MPI_Allgatherv(local.data(), number[this->process_id], mpi_type_t,
+		               x_new.data(), number.data(), positions.data(), mpi_type_t, MPI_COMM_WORLD);
+	};
+
+	gather();
+
+	do
+	{
+		iteration++;
+		this->trace->set_iteration(iteration);
+		x_old.swap(x_new);
+
+		auto check = this->is_check_iteration(iteration);
+		std::fill(local_parts.begin(), local_parts.begin() + width, 0.0);
+
+		{
+			m_trace::scope region(*this->trace, "rows");
+			for (auto i = 0; i < rows; ++i)
+			{
+				auto g = first_row + i;
+				auto &coefficients = (*this->coeff_matrix)[i];
+				auto sums = local.data() + i * width;
+
+				for (size_t c = 0; c < width; ++c)
+				{
+					sums[c] = (*this->right_hand_block)[i][active[c]];
+				}
+
+				// Every coefficient is loaded once for all the right-hand sides
+				for (size_t j = 0; j < size; ++j)
+				{
+					if (j == g)
+					{
+						continue;
+					}
+
+					auto a = coefficients[j];
+					auto x = x_old.data() + j * width;
+					for (size_t c = 0; c < width; ++c)
+					{
+						sums[c] -= a * x[c];
+					}
+				}
+
+				auto diagonal = coefficients[g];
+				for (size_t c = 0; c < width; ++c)
+				{
+					sums[c] /= diagonal;
+					if (check)
+					{
+						auto delta = sums[c] - x_old[g * width + c];
+						this->accumulate_norm(local_parts[c], use_residual ? diagonal * delta : delta);
+					}
+				}
+			}
+		}
+
+		gather();
+
+		if (!check && iteration < this->max_iterations)
+		{
+			continue;
+		}
+
+		std::vector<double> parts(local_parts.begin(), local_parts.begin() + width);
+		auto norms = this->reduce_norms(parts);
+
+		// Finished columns are stored and dropped, the rest are compacted in place
+		std::vector<size_t> kept_columns;
+		for (size_t c = 0; c < width; ++c)
+		{
+			auto done = norms[c] / right_hand_norms[active[c]] < this->precision;
+			if (done || iteration >= this->max_iterations)
+			{
+				for (auto i = 0; i < rows; ++i)
+				{
+					(*this->approximation_block)[i][active[c]] = local[i * width + c];
+				}
+				iterations[active[c]] = done ? iteration : 0;
+			}
+			else
+			{
+				kept_columns.push_back(c);
+			}
+		}
+
+		auto kept = kept_columns.size();
+		if (kept < width)
+		{
+			for (size_t j = 0; j < size; ++j)
+			{
+				for (size_t c = 0; c < kept; ++c)
+				{
+					x_new[j * kept + c] = x_new[j * width + kept_columns[c]];
+				}
+			}
+			for (auto i = 0; i < rows; ++i)
+			{
+				for (size_t c = 0; c < kept; ++c)
+				{
+					local[i * kept + c] = local[i * width + kept_columns[c]];
+				}
+			}
+			for (size_t c = 0; c < kept; ++c)
+			{
+				active[c] = active[kept_columns[c]];
+			}
+		}
+
+		width = kept;
+	}
+	while (iteration < this->max_iterations && width > 0);
+
+	auto converged = true;
+	for (size_t c = 0; c < k; ++c)
+	{
+		converged = converged && iterations[c] != 0;
+	}
+
+	if (this->process_id == this->ROOT_ID)
+	{
+		for (size_t c = 0; c < k; ++c)
+		{
+			std::cout << "Right-hand side " << c << ": converged: " << (iterations[c] != 0 ? "true" : "false")
+				<< ", iterations: " << (iterations[c] != 0 ? iterations[c] : iteration) << std::endl;
+		}
+	}
+
+	return std::make_pair(converged, iteration);
+}
+
+std::pair<bool, size_t> mpi_tester::apply_chebyshev_jacobi() const
+{
+	auto relaxation_radius = this->radius;
+
+	if (relaxation_radius == 0)
+	{
+		relaxation_radius = this->estimate_jacobi_radius(RADIUS_ESTIMATION_ITERATIONS);
+
+		if (this->process_id == this->ROOT_ID)
+		{
+			std::cout << "Estimated Jacobi spectral radius: " << relaxation_radius
+				<< " after " << RADIUS_ESTIMATION_ITERATIONS << " iterations" << std::endl;
+		}
+		if (relaxation_radius >= 1.0)
+		{
+			throw std::runtime_error("Chebyshev acceleration needs a Jacobi spectral radius below 1!");
+		}
+	}
+
 	auto x_old = std::make_shared<m_vector>(this->get_size());
 	auto x_new = std::make_shared<m_vector>(this->get_size());
-
 	auto rows = (*this->rows_number_distribution)[this->process_id];
+	auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+	auto use_residual = this->stop_criterion == RESIDUAL_CRITERION;
+	auto square = relaxation_radius * relaxation_radius;
 
-	MPI_Allgatherv(this->right_hand_side->get_data()->data(), rows, MPI_DOUBLE,
-	               x_new->get_data()->data(),
+	// Own rows of the iterate before the current one
+	std::vector<type_t> previous(rows);
+	for (auto i = 0; i < rows; ++i)
+	{
+		previous[i] = this->get_initial_guess()[i];
+	}
+
+	MPI_Allgatherv(this->get_initial_guess().get_data()->data(), rows, mpi_type_t,
+	               x_new->get_data()->data(), this->rows_number_distribution->data(),
+	               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+
+	auto right_hand_norm = this->get_right_hand_norm();
+	size_t iteration = 0;
+	auto converged = false;
+	auto weight = 1.0;
+
+	do
+	{
+		iteration++;
+		this->trace->set_iteration(iteration);
+		x_old.swap(x_new);
+
+		// Weights of the Chebyshev polynomials for eigenvalues of the Jacobi matrix in [-rho, rho]
+		weight = iteration == 1 ? 1.0 : iteration == 2 ? 1.0 / (1.0 - square / 2) : 1.0 / (1.0 - square * weight / 4);
+
+		auto check = this->is_check_iteration(iteration);
+		auto local_part = 0.0;
+
+		{
+			m_trace::scope region(*this->trace, "rows");
+			for (auto i = 0; i < rows; ++i)
+			{
+				auto g = first_row + i;
+				auto current = (*x_old)[g];
+				auto jacobi = this->row_update(i, *x_old);
+
+				(*this->approximation)[i] = weight * (jacobi - previous[i]) + previous[i];
+				previous[i] = current;
+
+				if (check)
+				{
+					// The plain Jacobi step still measures the residual of the current iterate
+					auto delta = jacobi - current;
+					this->accumulate_norm(local_part, use_residual ? (*this->coeff_matrix)[i][g] * delta : delta);
+				}
+			}
+		}
+
+		{
+			m_trace::scope region(*this->trace, "MPI_Allgatherv", this->get_size() * sizeof(type_t));
+			MPI_Allgatherv(this->approximation->get_data()->data(), rows, mpi_type_t,
+			               x_new->get_data()->data(), this->rows_number_distribution->data(),
+			               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+		}
+
+		if (check)
+		{
+			auto residual = this->reduce_norm(local_part) / right_hand_norm;
+			this->trace->set_residual(residual);
+			converged = residual < this->precision;
+		}
+	}
+	while (iteration < this->max_iterations && !converged);
+
+	return std::make_pair(converged, iteration);
+}
+
+std::pair<bool, size_t> mpi_tester::apply_shared_jacobi() const
+{
+	auto size = this->get_size();
+	auto rows = static_cast<size_t>((*this->rows_number_distribution)[this->process_id]);
+	auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+	auto use_residual = this->stop_criterion == RESIDUAL_CRITERION;
+
+	// x_old and x_new exist once per node instead of once per process
+	m_shared_window window(size, 2, first_row, rows, MPI_COMM_WORLD);
+
+	if (this->process_id == this->ROOT_ID)
+	{
+		std::cout << "Shared windows: " << window.get_nodes() << " nodes, "
+			<< window.get_node_size() << " processes on the root node" << std::endl;
+	}
+
+	size_t old_buffer = 0, new_buffer = 1;
+	auto initial = window.get_buffer(new_buffer);
+	for (size_t i = 0; i < rows; ++i)
+	{
+		initial[first_row + i] = this->get_initial_guess()[i];
+	}
+	window.exchange(new_buffer);
+
+	auto right_hand_norm = this->get_right_hand_norm();
+	size_t iteration = 0;
+	auto converged = false;
+
+	do
+	{
+		iteration++;
+		this->trace->set_iteration(iteration);
+		std::swap(old_buffer, new_buffer);
+
+		auto x_old = window.get_buffer(old_buffer);
+		auto x_new = window.get_buffer(new_buffer);
+		auto check = this->is_check_iteration(iteration);
+		auto local_part = 0.0;
+
+		{
+			m_trace::scope region(*this->trace, "rows");
+			for (size_t i = 0; i < rows; ++i)
+			{
+				auto g = first_row + i;
+				auto &row = (*this->coeff_matrix)[i];
+				auto value = (*this->right_hand_side)[i];
+				for (size_t j = 0; j < g; ++j)
+					value -= row[j] * x_old[j];
+				for (auto j = g + 1; j < size; ++j)
+					value -= row[j] * x_old[j];
+				value /= row[g];
+
+				// Written straight into the node copy, there is no local buffer to gather from
+				x_new[g] = value;
+
+				if (check)
+				{
+					auto delta = value - x_old[g];
+					this->accumulate_norm(local_part, use_residual ? row[g] * delta : delta);
+				}
+			}
+		}
+
+		{
+			m_trace::scope region(*this->trace, "shared exchange",
+			                      window.is_leader() ? size * sizeof(type_t) : 0);
+			window.exchange(new_buffer);
+		}
+
+		if (check)
+		{
+			auto residual = this->reduce_norm(local_part) / right_hand_norm;
+			this->trace->set_residual(residual);
+			converged = residual < this->precision;
+		}
+	}
+	while (iteration < this->max_iterations && !converged);
+
+	// Only the own rows of the last iterate are taken out of the window for the final gather
+	auto result = window.get_buffer(new_buffer);
+	for (size_t i = 0; i < rows; ++i)
+	{
+		(*this->approximation)[i] = result[first_row + i];
+	}
+
+	return std::make_pair(converged, iteration);
+}
+
+std::pair<bool, size_t> mpi_tester::apply_anderson_jacobi() const
+{
+	auto x = std::make_shared<m_vector>(this->get_size());
+	auto rows = static_cast<size_t>((*this->rows_number_distribution)[this->process_id]);
+	auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+	auto use_residual = this->stop_criterion == RESIDUAL_CRITERION;
+
+	// Own rows of the Jacobi image g = G(x) and of the step f = g - x, with their differences
+	// between successive iterations for the last depth iterations, the oldest first
+	std::vector<type_t> g(rows), f(rows), g_previous(rows), f_previous(rows);
+	std::vector<std::vector<type_t>> g_differences, f_differences;
+
+	MPI_Allgatherv(this->get_initial_guess().get_data()->data(), static_cast<int>(rows), mpi_type_t,
+	               x->get_data()->data(), this->rows_number_distribution->data(),
+	               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+
+	auto right_hand_norm = this->get_right_hand_norm();
+	size_t iteration = 0;
+	auto converged = false;
+
+	do
+	{
+		iteration++;
+		this->trace->set_iteration(iteration);
+
+		auto check = this->is_check_iteration(iteration);
+		auto local_part = 0.0;
+
+		{
+			m_trace::scope region(*this->trace, "rows");
+			for (size_t i = 0; i < rows; ++i)
+			{
+				g[i] = this->row_update(i, *x);
+				f[i] = g[i] - (*x)[first_row + i];
+
+				if (check)
+				{
+					this->accumulate_norm(local_part, use_residual ? (*this->coeff_matrix)[i][first_row + i] * f[i] : f[i]);
+				}
+			}
+		}
+
+		if (iteration > 1)
+		{
+			if (f_differences.size() == this->depth)
+			{
+				f_differences.erase(f_differences.begin());
+				g_differences.erase(g_differences.begin());
+			}
+
+			f_differences.emplace_back(rows);
+			g_differences.emplace_back(rows);
+			for (size_t i = 0; i < rows; ++i)
+			{
+				f_differences.back()[i] = f[i] - f_previous[i];
+				g_differences.back()[i] = g[i] - g_previous[i];
+			}
+		}
+
+		f_previous.swap(f);
+		g_previous.swap(g);
+
+		// x = g - dG * gamma, where gamma minimizes |f - dF * gamma|
+		auto history = f_differences.size();
+		std::copy(g_previous.begin(), g_previous.end(), this->approximation->get_data()->begin());
+
+		if (history > 0)
+		{
+			// The upper triangle of the Gram matrix and the right-hand side travel in one reduction
+			std::vector<type_t> local_sums(history * (history + 1) / 2 + history, 0);
+			size_t position = 0;
+
+			for (size_t a = 0; a < history; ++a)
+			{
+				for (size_t b = a; b < history; ++b, ++position)
+				{
+					for (size_t i = 0; i < rows; ++i)
+					{
+						local_sums[position] += f_differences[a][i] * f_differences[b][i];
+					}
+				}
+			}
+			for (size_t a = 0; a < history; ++a, ++position)
+			{
+				for (size_t i = 0; i < rows; ++i)
+				{
+					local_sums[position] += f_differences[a][i] * f_previous[i];
+				}
+			}
+
+			auto sums = this->reduce_sums(local_sums);
+			std::vector<std::vector<type_t>> gram(history, std::vector<type_t>(history));
+			std::vector<type_t> projection(sums.end() - history, sums.end());
+
+			position = 0;
+			for (size_t a = 0; a < history; ++a)
+			{
+				for (size_t b = a; b < history; ++b, ++position)
+				{
+					gram[a][b] = gram[b][a] = sums[position];
+				}
+			}
+
+			auto gamma = solve_small_system(gram, projection);
+			for (size_t a = 0; a < history; ++a)
+			{
+				for (size_t i = 0; i < rows; ++i)
+				{
+					(*this->approximation)[i] -= gamma[a] * g_differences[a][i];
+				}
+			}
+		}
+
+		{
+			m_trace::scope region(*this->trace, "MPI_Allgatherv", this->get_size() * sizeof(type_t));
+			MPI_Allgatherv(this->approximation->get_data()->data(), static_cast<int>(rows), mpi_type_t,
+			               x->get_data()->data(), this->rows_number_distribution->data(),
+			               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+		}
+
+		if (check)
+		{
+			auto residual = this->reduce_norm(local_part) / right_hand_norm;
+			this->trace->set_residual(residual);
+			converged = residual < this->precision;
+		}
+	}
+	while (iteration < this->max_iterations && !converged);
+
+	return std::make_pair(converged, iteration);
+}
+
+std::vector<type_t> mpi_tester::solve_small_system(std::vector<std::vector<type_t>> a, std::vector<type_t> b)
+{
+	auto n = b.size();
+
+	// A relative shift keeps nearly dependent histories solvable
+	type_t trace = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		trace += a[i][i];
+	}
+	for (size_t i = 0; i < n; ++i)
+	{
+		a[i][i] += trace * 1e-12;
+	}
+
+	for (size_t k = 0; k < n; ++k)
+	{
+		auto pivot = k;
+		for (auto i = k + 1; i < n; ++i)
+		{
+			if (std::fabs(a[i][k]) > std::fabs(a[pivot][k]))
+			{
+				pivot = i;
+			}
+		}
+		std::swap(a[k], a[pivot]);
+		std::swap(b[k], b[pivot]);
+
+		if (a[k][k] == 0)
+		{
+			continue;
+		}
+		for (auto i = k + 1; i < n; ++i)
+		{
+			auto factor = a[i][k] / a[k][k];
+			for (auto j = k; j < n; ++j)
+			{
+				a[i][j] -= factor * a[k][j];
+			}
+			b[i] -= factor * b[k];
+		}
+	}
+
+	std::vector<type_t> result(n, 0);
+	for (auto k = n; k-- > 0;)
+	{
+		if (a[k][k] == 0)
+		{
+			continue;
+		}
+
+		auto sum = b[k];
+		for (auto j = k + 1; j < n; ++j)
+		{
+			sum -= a[k][j] * result[j];
+		}
+		result[k] = sum / a[k][k];
+	}
+
+	return result;
+}
+
+std::pair<bool, size_t> mpi_tester::apply_pipelined_jacobi() const
+{
+	auto size = this->get_size();
+	auto rows = (*this->rows_number_distribution)[this->process_id];
+	auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+	auto last_row = first_row + rows;
+	auto use_residual = this->stop_criterion == RESIDUAL_CRITERION;
+	auto use_pieces = this->overlap_mode == PIECES_OVERLAP;
+
+	auto x_old = std::make_shared<m_vector>(size);
+	auto x_new = std::make_shared<m_vector>(size);
+	std::vector<type_t> partial(rows);
+	std::vector<MPI_Request> requests(use_pieces ? this->total_processes : 1);
+
+	MPI_Allgatherv(this->get_initial_guess().get_data()->data(), rows, mpi_type_t,
+	               x_old->get_data()->data(),
 	               this->rows_number_distribution->data(),
+	               this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD);
+
+	auto right_hand_norm = this->get_right_hand_norm();
+
+	size_t iteration = 1;
+	auto converged = false;
+	this->trace->set_iteration(iteration);
+
+	// The first sweep has the whole vector at hand
+	{
+		m_trace::scope region(*this->trace, "rows");
+		for (auto i = 0; i < rows; ++i)
+		{
+			partial[i] = (*this->right_hand_side)[i];
+		}
+		this->subtract_columns(partial, *x_old, 0, 0, size);
+		for (auto i = 0; i < rows; ++i)
+		{
+			(*approximation)[i] = partial[i] / (*coeff_matrix)[i][first_row + i];
+		}
+	}
+
+	auto overlapped_total = 0.0;
+	auto wait_total = 0.0;
+
+	while (true)
+	{
+		auto check = this->is_check_iteration(iteration);
+		auto local_part = 0.0;
+		auto posted = MPI_Wtime();
+
+		if (use_pieces)
+		{
+			// One broadcast per owner, so the remote blocks can be consumed in arrival order
+			std::copy(approximation->get_data()->begin(), approximation->get_data()->begin() + rows,
+			          x_new->get_data()->begin() + first_row);
+			// The bytes are counted where the transfers are posted, the waits below only add time
+			m_trace::scope region(*this->trace, "MPI_Ibcast", size * sizeof(type_t));
+			for (auto p = 0; p < this->total_processes; ++p)
+			{
+				MPI_Ibcast(x_new->get_data()->data() + (*this->rows_positions_distribution)[p],
+				           (*this->rows_number_distribution)[p], mpi_type_t, p, MPI_COMM_WORLD, &requests[p]);
+			}
+		}
+		else
+		{
+			m_trace::scope region(*this->trace, "MPI_Iallgatherv", size * sizeof(type_t));
+			MPI_Iallgatherv(approximation->get_data()->data(), rows, mpi_type_t,
+			                x_new->get_data()->data(), this->rows_number_distribution->data(),
+			                this->rows_positions_distribution->data(), mpi_type_t, MPI_COMM_WORLD, &requests[0]);
+		}
+
+		// While the block is in flight: the convergence part and the local columns of the next product
+		{
+			m_trace::scope region(*this->trace, "rows");
+			for (auto i = 0; i < rows; ++i)
+			{
+				if (check)
+				{
+					auto delta = (*approximation)[i] - (*x_old)[first_row + i];
+					this->accumulate_norm(local_part, use_residual ? (*coeff_matrix)[i][first_row + i] * delta : delta);
+				}
+				partial[i] = (*this->right_hand_side)[i];
+			}
+			this->subtract_columns(partial, *approximation, first_row, first_row, last_row);
+		}
+
+		auto overlapped = MPI_Wtime() - posted;
+		auto wait = 0.0;
+
+		if (use_pieces)
+		{
+			for (auto left = this->total_processes; left > 0; --left)
+			{
+				auto index = MPI_UNDEFINED;
+				auto before = MPI_Wtime();
+				{
+					m_trace::scope region(*this->trace, "MPI_Waitany", 0);
+					MPI_Waitany(this->total_processes, requests.data(), &index, MPI_STATUS_IGNORE);
+				}
+				wait += MPI_Wtime() - before;
+
+				if (index != this->process_id)
+				{
+					m_trace::scope region(*this->trace, "rows");
+					auto first_column = static_cast<size_t>((*this->rows_positions_distribution)[index]);
+					this->subtract_columns(partial, *x_new, 0, first_column,
+					                       first_column + (*this->rows_number_distribution)[index]);
+				}
+			}
+		}
+		else
+		{
+			auto before = MPI_Wtime();
+			{
+				m_trace::scope region(*this->trace, "MPI_Wait", 0);
+				MPI_Wait(&requests[0], MPI_STATUS_IGNORE);
+			}
+			wait = MPI_Wtime() - before;
+
+			m_trace::scope region(*this->trace, "rows");
+			this->subtract_columns(partial, *x_new, 0, 0, first_row);
+			this->subtract_columns(partial, *x_new, 0, last_row, size);
+		}
+
+		overlapped_total += overlapped;
+		wait_total += wait;
+
+		std::stringstream ss;
+		ss << "Iteration " << iteration << ": overlapped compute " << overlapped * 1000 << "ms, "
+			<< "exposed wait " << wait * 1000 << "ms, "
+			<< "hidden " << (overlapped + wait > 0 ? 100 * overlapped / (overlapped + wait) : 100) << "%";
+		auto msg = ss.str();
+		log(msg);
+
+		if (check)
+		{
+			auto residual = this->reduce_norm(local_part) / right_hand_norm;
+			this->trace->set_residual(residual);
+			converged = residual < this->precision;
+		}
+
+		if (converged || iteration >= this->max_iterations)
+		{
+			break;
+		}
+
+		iteration++;
+		this->trace->set_iteration(iteration);
+		x_old.swap(x_new);
+
+		m_trace::scope region(*this->trace, "rows");
+		for (auto i = 0; i < rows; ++i)
+		{
+			(*approximation)[i] = partial[i] / (*coeff_matrix)[i][first_row + i];
+		}
+	}
+
+	double totals[] = {overlapped_total, wait_total};
+	double global_totals[] = {0.0, 0.0};
+	{
+		m_trace::scope region(*this->trace, "MPI_Reduce", sizeof(totals));
+		MPI_Reduce(totals, global_totals, 2, MPI_DOUBLE, MPI_SUM, this->ROOT_ID, MPI_COMM_WORLD);
+	}
+
+	if (this->process_id == this->ROOT_ID)
+	{
+		auto per_iteration = 1000.0 / (iteration * this->total_processes);
+		auto sum = global_totals[0] + global_totals[1];
+		std::cout << "Overlap (" << this->overlap_mode << "): "
+			<< "overlapped compute " << global_totals[0] * per_iteration << "ms, "
+			<< "exposed wait " << global_totals[1] * per_iteration << "ms per iteration, "
+			<< "communication hidden: " << (sum > 0 ? 100 * global_totals[0] / sum : 100) << "%" << std::endl;
+	}
+
+	return std::make_pair(converged, iteration);
+}
+
+std::pair<bool, size_t> mpi_tester::apply_simd_jacobi() const
+{
+	typedef m_row_kernel::kernel_t kernel_t;
+
+	auto rows = (*this->rows_number_distribution)[this->process_id];
+	auto first_row = static_cast<size_t>((*this->rows_positions_distribution)[this->process_id]);
+	auto use_residual = this->stop_criterion == RESIDUAL_CRITERION;
+
+	m_row_kernel kernel(*this->coeff_matrix, *this->right_hand_side, first_row, static_cast<size_t>(rows));
+	std::vector<kernel_t> x_old(this->get_size());
+	std::vector<kernel_t> x_new(this->get_size());
+	std::vector<kernel_t> local(rows);
+
+	for (auto i = 0; i < rows; ++i)
+	{
+		local[i] = static_cast<kernel_t>(this->get_initial_guess()[i]);
+	}
+
+	MPI_Allgatherv(local.data(), rows, MPI_DOUBLE,
+	               x_new.data(), this->rows_number_distribution->data(),
 	               this->rows_positions_distribution->data(), MPI_DOUBLE, MPI_COMM_WORLD);
 
-	auto iteration = 0;
+	if (this->thread_scaling)
+	{
+		this->print_thread_scaling(kernel, x_new);
+	}
+
+	auto right_hand_norm = this->get_right_hand_norm();
+	size_t iteration = 0;
+	auto converged = false;
 
 	do
 	{
 		iteration++;
+		this->trace->set_iteration(iteration);
 		x_old.swap(x_new);
 
-		for (auto i = 0; i < rows; ++i)
+		auto check = this->is_check_iteration(iteration);
+		auto local_part = 0.0;
+
 		{
-			auto g = i + this->process_id * rows;
-			(*approximation)[i] = (*this->right_hand_side)[i];
-			for (auto j = 0; j < g; ++j)
-				(*approximation)[i] -= (*coeff_matrix)[i][j] * (*x_old)[j];
-			for (auto j = g + 1; j < this->get_size(); ++j)
-				(*approximation)[i] -= (*coeff_matrix)[i][j] * (*x_old)[j];
-			(*approximation)[i] /= (*coeff_matrix)[i][g];
+			m_trace::scope region(*this->trace, "rows");
+			kernel.sweep(x_old.data(), local.data());
+
+			if (check)
+			{
+				for (auto i = 0; i < rows; ++i)
+				{
+					auto delta = local[i] - x_old[first_row + i];
+					this->accumulate_norm(local_part, use_residual ? kernel.get_diagonal(i) * delta : delta);
+				}
+			}
 		}
 
-		MPI_Allgatherv(approximation->get_data()->data(), rows, MPI_DOUBLE,
-		               x_new->get_data()->data(), this->rows_number_distribution->data(),
-		               this->rows_positions_distribution->data(), MPI_DOUBLE, MPI_COMM_WORLD);
+		{
+			m_trace::scope region(*this->trace, "MPI_Allgatherv", this->get_size() * sizeof(kernel_t));
+			MPI_Allgatherv(local.data(), rows, MPI_DOUBLE,
+			               x_new.data(), this->rows_number_distribution->data(),
+			               this->rows_positions_distribution->data(), MPI_DOUBLE, MPI_COMM_WORLD);
+		}
+
+		if (check)
+		{
+			auto residual = this->reduce_norm(local_part) / right_hand_norm;
+			this->trace->set_residual(residual);
+			converged = residual < this->precision;
+		}
+	}
+	while (iteration < this->max_iterations && !converged);
+
+	for (auto i = 0; i < rows; ++i)
+	{
+		(*this->approximation)[i] = static_cast<type_t>(local[i]);
+	}
+
+	return std::make_pair(converged, iteration);
+}
+
+void mpi_tester::print_thread_scaling(const m_row_kernel &kernel, const std::vector<m_row_kernel::kernel_t> &x) const
+{
+#ifdef _OPENMP
+	auto max_threads = omp_get_max_threads();
+#else
+	// Without OpenMP the kernel always runs on the calling thread alone
+	auto max_threads = 1;
+#endif
+	auto base_time = 0.0;
+	std::vector<m_row_kernel::kernel_t> result(kernel.get_rows());
+
+	for (auto threads = 1; ; threads = std::min(2 * threads, max_threads))
+	{
+#ifdef _OPENMP
+		omp_set_num_threads(threads);
+#endif
+		MPI_Barrier(MPI_COMM_WORLD);
+
+		auto before = MPI_Wtime();
+		for (auto i = 0; i < THREAD_SCALING_SWEEPS; ++i)
+		{
+			kernel.sweep(x.data(), result.data());
+		}
+		auto local_time = (MPI_Wtime() - before) / THREAD_SCALING_SWEEPS;
+		auto time = 0.0;
+
+		// The slowest process defines the time of a distributed sweep
+		MPI_Reduce(&local_time, &time, 1, MPI_DOUBLE, MPI_MAX, this->ROOT_ID, MPI_COMM_WORLD);
+
+		if (this->process_id == this->ROOT_ID)
+		{
+			if (threads == 1)
+			{
+				base_time = time;
+			}
+			std::cout << "Threads: " << threads
+				<< ", sweep time: " << time * 1000 << "ms"
+				<< ", speedup: " << base_time / time
+				<< ", efficiency: " << 100 * base_time / (time * threads) << "%" << std::endl;
+		}
+
+		if (threads == max_threads)
+		{
+			break;
+		}
 	}
-	while (iteration < this->max_iterations && this->distance(x_new, x_old) >= this->precision);
 
-	return std::make_pair(this->distance(x_new, x_old) < this->precision, iteration);
+#ifdef _OPENMP
+	omp_set_num_threads(max_threads);
+#endif
 }
 
 size_t mpi_tester::get_size() const
@@ -463,31 +3343,80 @@ void mpi_tester::process() const
 {
 	log("Processing");
 
-	auto converged = this->apply_jacobi();
-	auto rows = (*this->rows_number_distribution)[this->process_id];
-	auto plain_approximation_data = std::make_shared<std::vector<type_t>>(this->matrix_rows);
+	if (this->compare && this->solver != JACOBI_SOLVER)
+	{
+		this->run_solver(JACOBI_SOLVER);
+	}
 
-	std::stringstream ss;
-	ss << "Local approximation: " << *approximation;
-	auto msg = ss.str();
-	log(msg);
+	std::pair<bool, size_t> converged;
 
-	auto x_new = std::make_shared<m_vector>(this->get_size());
+	if (this->cold_start)
+	{
+		this->cold_run = true;
+		auto cold = this->run_solver(this->solver);
+		this->cold_run = false;
+		converged = this->run_solver(this->solver);
 
-	MPI_Gatherv(this->approximation->get_data()->data(), rows, MPI_DOUBLE,
-	            plain_approximation_data->data(), this->rows_number_distribution->data(),
-	            this->rows_positions_distribution->data(), MPI_DOUBLE,
-	            this->ROOT_ID, MPI_COMM_WORLD);
+		if (this->process_id == this->ROOT_ID)
+		{
+			std::cout << "Warm start saved "
+				<< static_cast<long long>(cold.second) - static_cast<long long>(converged.second) << " iterations: "
+				<< cold.second << " from a cold start, " << converged.second << " from the initial approximation"
+				<< std::endl;
+		}
+	}
+	else
+	{
+		converged = this->run_solver(this->solver);
+	}
 
-	if (this->process_id == ROOT_ID)
+	std::string msg;
+
+	if (this->right_hand_columns > 1)
+	{
+		this->gather_approximation_block();
+	}
+	// The grid solver leaves the whole approximation on the root by itself
+	else if (!this->use_grid)
 	{
-		this->approximation->fill(plain_approximation_data, this->get_size());
+		auto rows = (*this->rows_number_distribution)[this->process_id];
+		auto plain_approximation_data = std::make_shared<std::vector<type_t>>(
+			this->process_id == this->ROOT_ID ? this->matrix_rows : 0);
 
+		std::stringstream ss;
+		ss << "Local approximation: " << *approximation;
+		msg = ss.str();
+		log(msg);
+
+		m_trace::scope region(*this->trace, "MPI_Gatherv", rows * sizeof(type_t));
+		MPI_Gatherv(this->approximation->get_data()->data(), rows, mpi_type_t,
+		            plain_approximation_data->data(), this->rows_number_distribution->data(),
+		            this->rows_positions_distribution->data(), mpi_type_t,
+		            this->ROOT_ID, MPI_COMM_WORLD);
+
+		if (this->process_id == ROOT_ID)
+		{
+			this->approximation->fill(plain_approximation_data, this->get_size());
+		}
+	}
+
+	if (this->process_id == ROOT_ID)
+	{
 		std::stringstream ss2;
-		ss2 << "Global approximation: " << *approximation << ", "
-			<< "Converged: " << (converged.first ? "true" : "false") << ", iterations: " << converged.second;
+		ss2 << "Global approximation: ";
+		if (this->right_hand_columns > 1)
+		{
+			ss2 << *approximation_block;
+		}
+		else
+		{
+			ss2 << *approximation;
+		}
+		ss2 << ", Converged: " << (converged.first ? "true" : "false") << ", iterations: " << converged.second;
 		msg = ss2.str();
 		log(msg);
 		print_answer();
 	}
+
+	this->trace->write(this->trace_prefix, MPI_COMM_WORLD);
 }
@@ -1,32 +1,135 @@
 #ifndef LAB02_MPI_TESTER_H
 #define LAB02_MPI_TESTER_H
 
-#include "m_matrix.h"
+#include "m_generator.h"
+#include "m_row_kernel.h"
+#include "m_halo.h"
+#include "m_process_grid.h"
+#include "m_trace.h"
+#include "m_block_lu.h"
+#include "m_shared_window.h"
 #include <string>
 
 class mpi_tester
 {
 	static const std::string DEFAULT_OUTPUT_FILE_NAME;
 	static const std::string USE_GENERATED_MATRICES_ARG;
+	static const std::string GENERATOR_FAMILY_ARG;
+	static const std::string GENERATOR_BANDWIDTH_ARG;
+	static const std::string GENERATOR_SEED_ARG;
 	static const std::string OUTPUT_FILE_ARG;
 	static const std::string VERBOSE_ARG;
+	static const std::string CHECK_INTERVAL_ARG;
+	static const std::string NORM_ARG;
+	static const std::string STOP_CRITERION_ARG;
+	static const std::string L2_NORM;
+	static const std::string MAX_NORM;
+	static const std::string DIFFERENCE_CRITERION;
+	static const std::string RESIDUAL_CRITERION;
+	static const std::string OVERLAP_ARG;
+	static const std::string GATHER_OVERLAP;
+	static const std::string PIECES_OVERLAP;
+	static const std::string THREADS_NUMBER_ARG;
+	static const std::string KERNEL_ARG;
+	static const std::string PLAIN_KERNEL;
+	static const std::string SIMD_KERNEL;
+	static const std::string THREAD_SCALING_ARG;
+	static const int THREAD_SCALING_SWEEPS;
+	static const std::string SOLVER_ARG;
+	static const std::string JACOBI_SOLVER;
+	static const std::string GAUSS_SEIDEL_SOLVER;
+	static const std::string RED_BLACK_SOLVER;
+	static const std::string SOR_SOLVER;
+	static const std::string CG_SOLVER;
+	static const std::string GMRES_SOLVER;
+	static const std::string BLOCK_JACOBI_SOLVER;
+	static const std::string RESTART_ARG;
+	static const std::string PRECONDITIONER_ARG;
+	static const std::string NO_PRECONDITIONER;
+	static const std::string JACOBI_PRECONDITIONER;
+	static const std::string SPARSE_ARG;
+	static const std::string PARTITION_ARG;
+	static const std::string ROWS_PARTITION;
+	static const std::string NONZEROS_PARTITION;
+	static const std::string COST_PARTITION;
+	static const int COST_MEASUREMENT_REPEATS;
+	static const std::string GRID_ARG;
+	static const std::string GRID_BLOCK_ARG;
+	static const std::string OMEGA_ARG;
+	static const std::string AUTO_OMEGA;
+	static const std::string COMPARE_ARG;
+	static const std::string INITIAL_GUESS_ARG;
+	static const std::string INITIAL_GUESS_FORMAT_ARG;
+	static const std::string TEXT_FORMAT;
+	static const std::string BINARY_FORMAT;
+	static const std::string COLD_START_ARG;
+	static const std::string TRACE_ARG;
+	static const std::string ACCELERATION_ARG;
+	static const std::string NO_ACCELERATION;
+	static const std::string CHEBYSHEV_ACCELERATION;
+	static const std::string ANDERSON_ACCELERATION;
+	static const std::string RADIUS_ARG;
+	static const std::string DEPTH_ARG;
+	static const std::string SHARED_ARG;
+	static const size_t RADIUS_ESTIMATION_ITERATIONS;
 	static const int ROOT_ID;
 
 	std::string input_file_matrix = "";
 	std::string output_file = "";
 	bool use_gen_input = false;
+	std::string generator_family = m_generator::TRIANGULAR_FAMILY;
+	size_t generator_bandwidth = 1;
+	unsigned long long generator_seed = 0;
 	bool verbose = false;
 	size_t matrix_rows = 0;
 	size_t matrix_columns = 0;
+	size_t right_hand_columns = 1;
 	int total_processes = 0;
 	int process_id = 0;
-	size_t cells_per_process;
-	size_t rows_per_process;
+	size_t cells_per_process = 0;
+	size_t rows_per_process = 0;
 	double precision = -1;
 	size_t max_iterations = 0;
+	size_t check_interval = 1;
+	std::string norm = L2_NORM;
+	std::string stop_criterion = DIFFERENCE_CRITERION;
+	std::string overlap_mode = "";
+	std::string kernel = PLAIN_KERNEL;
+	int threads = 0;
+	bool thread_scaling = false;
+	std::string solver = JACOBI_SOLVER;
+	double omega = 1.0;
+	bool auto_omega = false;
+	bool compare = false;
+	std::string initial_guess_file = "";
+	std::string initial_guess_format = TEXT_FORMAT;
+	bool cold_start = false;
+	// Set while the reference cold run of a warm-started solve is in progress
+	mutable bool cold_run = false;
+	std::string trace_prefix = "";
+	std::string acceleration = NO_ACCELERATION;
+	// Spectral radius bound of the Jacobi iteration matrix, estimated when not passed
+	double radius = 0;
+	size_t depth = 5;
+	bool use_shared = false;
+	std::shared_ptr<m_trace> trace;
+	size_t restart = 30;
+	std::string preconditioner = NO_PRECONDITIONER;
+	bool sparse = false;
+	std::string partition = ROWS_PARTITION;
+	bool use_grid = false;
+	size_t grid_block = 64;
+	std::shared_ptr<m_process_grid> grid;
+	m_csr_matrix::matrix_t sparse_matrix;
+	std::shared_ptr<m_halo> halo;
 	m_matrix::matrix_t coeff_matrix;
 	m_vector::vector_t right_hand_side;
+	// Used instead of the vectors when the input holds more than one right-hand side
+	m_matrix::matrix_t right_hand_block;
+	m_matrix::matrix_t approximation_block;
 	m_vector::vector_t approximation;
+	// Rows of the loaded starting approximation owned by the process
+	m_vector::vector_t initial_guess;
 	m_vector::vector_t answer;
 	std::shared_ptr<std::vector<int>> rows_number_distribution;
 	std::shared_ptr<std::vector<int>> rows_positions_distribution;
@@ -34,26 +137,66 @@ class mpi_tester
 	std::shared_ptr<std::vector<int>> cells_positions_distribution;
 
 	static void check_arguments_available(const int total, const int current, const int required);
-	static double distance(m_vector::vector_t &new_appr, m_vector::vector_t &old_appr);
 	static std::string get_help();
 	static double parse_double(const char *value, const char *parse_error, const char *overflow_error);
 	static int parse_int(const char *value, const char *parse_error, const char *overflow_error);
 	static size_t parse_size_t(const char *value, const char *parse_error, const char *overflow_error);
 
 	void calculate_data_distribution();
+	void rebalance();
+	std::vector<double> measure_row_weights() const;
+	void migrate_rows(const std::vector<int> &new_rows_number, const std::vector<int> &new_rows_positions);
 	void read_matrix();
+	void generate_initial_data();
+	void init_sparse();
+	void load_sparse_matrix();
+	void init_grid();
+	void load_initial_guess();
+	m_vector::vector_t read_initial_guess() const;
+	const m_vector &get_initial_guess() const;
 	void receive_meta_data();
 	void receive_initial_data();
 	void send_initial_data() const;
 	void send_meta_data() const;
 	void check_range() const;
 	void check_arguments() const;
+	void check_right_hand_columns() const;
+	void accumulate_norm(double &local_part, const type_t value) const;
+	double reduce_norm(const double local_part) const;
+	std::vector<double> reduce_norms(const std::vector<double> &local_parts) const;
+	bool is_check_iteration(const size_t iteration) const;
+	double get_right_hand_norm() const;
+	void subtract_columns(std::vector<type_t> &partial, const m_vector &x, const size_t x_offset,
+	                      const size_t first_column, const size_t last_column) const;
 	void print_answer() const;
+	void gather_approximation_block() const;
 	void print_process_id() const;
 	void print_data_distribution() const;
 	void log(std::string &msg) const;
 	void log(char *const msg) const;
+	type_t row_update(const size_t row, const m_vector &x) const;
+	double estimate_jacobi_radius(const size_t iterations) const;
+	std::pair<bool, size_t> solve(const std::string &name) const;
+	std::pair<bool, size_t> run_solver(const std::string &name) const;
 	std::pair<bool, size_t> apply_jacobi() const;
+	std::pair<bool, size_t> apply_gauss_seidel(const bool red_black, const double relaxation) const;
+	std::pair<bool, size_t> apply_sor() const;
+	std::pair<bool, size_t> apply_conjugate_gradient() const;
+	std::pair<bool, size_t> apply_gmres() const;
+	std::pair<bool, size_t> apply_block_jacobi() const;
+	std::pair<bool, size_t> apply_sparse_jacobi() const;
+	std::pair<bool, size_t> apply_grid_jacobi() const;
+	std::pair<bool, size_t> apply_batched_jacobi() const;
+	std::pair<bool, size_t> apply_chebyshev_jacobi() const;
+	std::pair<bool, size_t> apply_anderson_jacobi() const;
+	std::pair<bool, size_t> apply_shared_jacobi() const;
+	static std::vector<type_t> solve_small_system(std::vector<std::vector<type_t>> a, std::vector<type_t> b);
+	void multiply(const std::vector<type_t> &local, m_vector &full, std::vector<type_t> &result) const;
+	void precondition(const std::vector<type_t> &local, std::vector<type_t> &result) const;
+	std::vector<type_t> reduce_sums(const std::vector<type_t> &local_sums) const;
+	std::pair<bool, size_t> apply_pipelined_jacobi() const;
+	std::pair<bool, size_t> apply_simd_jacobi() const;
+	void print_thread_scaling(const m_row_kernel &kernel, const std::vector<m_row_kernel::kernel_t> &x) const;
 	size_t get_size() const;
 	std::string get_metadata() const;
 public:
@@ -67,6 +210,7 @@ public:
 			<< "input_file_matrix: " << obj.input_file_matrix 
 			<< " output_file: " << obj.output_file 
 			<< " use_gen_input: " << obj.use_gen_input 
+			<< " generator_family: " << obj.generator_family 
 			<< " matrix_rows: " << obj.matrix_rows 
 			<< " matrix_columns: " << obj.matrix_columns 
 			<< " total_processes: " << obj.total_processes 
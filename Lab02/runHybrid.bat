@@ -0,0 +1,3 @@
+mpiexec -n 2 -affinity_layout spr:N -env OMP_NUM_THREADS 16 x64\Release\Lab02.exe matrix.txt -o approximation.txt 0.000000000000001 100000 -g 8000 -kernel simd -ts
+mpiexec -n 2 -affinity_layout spr:N -env OMP_NUM_THREADS 16 x64\Release\Lab02.exe matrix400.txt -o approximation.txt 0.000000000000001 100000 -kernel simd
+@PAUSE
\ No newline at end of file
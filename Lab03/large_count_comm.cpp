@@ -0,0 +1,283 @@
+#include <limits>
+#include "large_count_comm.h"
+
+const int large_count_comm::TAG = 48;
+const large_count_comm::count_t large_count_comm::INT_LIMIT = std::numeric_limits<int>::max();
+
+large_count_comm::large_count_comm(const MPI_Comm comm, const unsigned long long bound) : comm(comm),
+                                                                                         small(bound <= INT_LIMIT)
+{
+	MPI_Comm_rank(comm, &this->process_id);
+	MPI_Comm_size(comm, &this->total_processes);
+}
+
+std::vector<int> large_count_comm::to_int(const std::vector<count_t> &values)
+{
+	return std::vector<int>(values.begin(), values.end());
+}
+
+#if MPI_VERSION >= 4
+std::vector<MPI_Count> large_count_comm::to_counts(const std::vector<count_t> &values)
+{
+	return std::vector<MPI_Count>(values.begin(), values.end());
+}
+
+std::vector<MPI_Aint> large_count_comm::to_displs(const std::vector<count_t> &values)
+{
+	return std::vector<MPI_Aint>(values.begin(), values.end());
+}
+#endif
+
+MPI_Datatype large_count_comm::create_type(const count_t count, const MPI_Datatype type)
+{
+	MPI_Datatype result;
+
+	if (count <= INT_LIMIT)
+	{
+		MPI_Type_contiguous(static_cast<int>(count), type, &result);
+		MPI_Type_commit(&result);
+		return result;
+	}
+
+	MPI_Aint lower_bound, extent;
+	MPI_Type_get_extent(type, &lower_bound, &extent);
+
+	MPI_Datatype chunk, chunks;
+	MPI_Type_contiguous(static_cast<int>(INT_LIMIT), type, &chunk);
+	MPI_Type_contiguous(static_cast<int>(count / INT_LIMIT), chunk, &chunks);
+
+	// The remainder follows the whole chunks
+	int lengths[2] = {1, static_cast<int>(count % INT_LIMIT)};
+	MPI_Aint displacements[2] = {0, static_cast<MPI_Aint>(count / INT_LIMIT * INT_LIMIT) * extent};
+	MPI_Datatype types[2] = {chunks, type};
+	MPI_Type_create_struct(lengths[1] > 0 ? 2 : 1, lengths, displacements, types, &result);
+	MPI_Type_commit(&result);
+
+	MPI_Type_free(&chunks);
+	MPI_Type_free(&chunk);
+	return result;
+}
+
+void large_count_comm::exchange(const void *send, const std::vector<int> &destinations,
+                                const std::vector<count_t> &send_counts, const std::vector<count_t> &send_displs,
+                                void *recv, const std::vector<int> &sources, const std::vector<count_t> &recv_counts,
+                                const std::vector<count_t> &recv_displs, const MPI_Datatype type) const
+{
+	MPI_Aint lower_bound, extent;
+	MPI_Type_get_extent(type, &lower_bound, &extent);
+
+	std::vector<MPI_Request> requests;
+	std::vector<MPI_Datatype> types;
+
+	// Both sides know every count, so empty parts are not sent at all
+	for (size_t i = 0; i < sources.size(); ++i)
+	{
+		if (recv_counts[i] > 0)
+		{
+			types.push_back(create_type(recv_counts[i], type));
+			requests.push_back(MPI_REQUEST_NULL);
+			MPI_Irecv(static_cast<char*>(recv) + recv_displs[i] * extent, 1, types.back(), sources[i], TAG,
+			          this->comm, &requests.back());
+		}
+	}
+
+	for (size_t i = 0; i < destinations.size(); ++i)
+	{
+		if (send_counts[i] > 0)
+		{
+			types.push_back(create_type(send_counts[i], type));
+			requests.push_back(MPI_REQUEST_NULL);
+			MPI_Isend(static_cast<const char*>(send) + send_displs[i] * extent, 1, types.back(), destinations[i], TAG,
+			          this->comm, &requests.back());
+		}
+	}
+
+	MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+
+	for (auto &t : types)
+	{
+		MPI_Type_free(&t);
+	}
+}
+
+void large_count_comm::scatterv(const void *send, const std::vector<count_t> &counts,
+                                const std::vector<count_t> &displs,
+                                void *recv, const count_t recv_count, const MPI_Datatype type, const int root) const
+{
+#if MPI_VERSION >= 4
+	MPI_Scatterv_c(send, to_counts(counts).data(), to_displs(displs).data(), type,
+	               recv, recv_count, type, root, this->comm);
+#else
+	if (this->small)
+	{
+		MPI_Scatterv(send, to_int(counts).data(), to_int(displs).data(), type,
+		             recv, static_cast<int>(recv_count), type, root, this->comm);
+		return;
+	}
+
+	auto in_place = recv == MPI_IN_PLACE;
+	std::vector<int> destinations, sources;
+	std::vector<count_t> send_counts, send_displs, recv_counts, recv_displs;
+
+	if (this->process_id == root)
+	{
+		for (auto p = 0; p < this->total_processes; ++p)
+		{
+			if (p != root || !in_place)
+			{
+				destinations.push_back(p);
+				send_counts.push_back(counts[p]);
+				send_displs.push_back(displs[p]);
+			}
+		}
+	}
+	if (!in_place)
+	{
+		sources.push_back(root);
+		recv_counts.push_back(recv_count);
+		recv_displs.push_back(0);
+	}
+
+	this->exchange(send, destinations, send_counts, send_displs, recv, sources, recv_counts, recv_displs, type);
+#endif
+}
+
+void large_count_comm::gatherv(const void *send, const count_t send_count,
+                               void *recv, const std::vector<count_t> &counts, const std::vector<count_t> &displs,
+                               const MPI_Datatype type, const int root) const
+{
+	auto is_root = this->process_id == root;
+
+#if MPI_VERSION >= 4
+	MPI_Gatherv_c(send, send_count, type,
+	              recv, is_root ? to_counts(counts).data() : nullptr, is_root ? to_displs(displs).data() : nullptr,
+	              type, root, this->comm);
+#else
+	if (this->small)
+	{
+		MPI_Gatherv(send, static_cast<int>(send_count), type,
+		            recv, is_root ? to_int(counts).data() : nullptr, is_root ? to_int(displs).data() : nullptr,
+		            type, root, this->comm);
+		return;
+	}
+
+	std::vector<int> destinations(1, root), sources;
+	std::vector<count_t> send_counts(1, send_count), send_displs(1, 0), recv_counts, recv_displs;
+
+	if (is_root)
+	{
+		for (auto p = 0; p < this->total_processes; ++p)
+		{
+			sources.push_back(p);
+			recv_counts.push_back(counts[p]);
+			recv_displs.push_back(displs[p]);
+		}
+	}
+
+	this->exchange(send, destinations, send_counts, send_displs, recv, sources, recv_counts, recv_displs, type);
+#endif
+}
+
+void large_count_comm::alltoallv(const void *send, const std::vector<count_t> &send_counts,
+                                 const std::vector<count_t> &send_displs,
+                                 void *recv, const std::vector<count_t> &recv_counts,
+                                 const std::vector<count_t> &recv_displs, const MPI_Datatype type) const
+{
+#if MPI_VERSION >= 4
+	MPI_Alltoallv_c(send, to_counts(send_counts).data(), to_displs(send_displs).data(), type,
+	                recv, to_counts(recv_counts).data(), to_displs(recv_displs).data(), type,
+	                this->comm);
+#else
+	if (this->small)
+	{
+		MPI_Alltoallv(send, to_int(send_counts).data(), to_int(send_displs).data(), type,
+		              recv, to_int(recv_counts).data(), to_int(recv_displs).data(), type,
+		              this->comm);
+		return;
+	}
+
+	std::vector<int> everyone(this->total_processes);
+	for (auto p = 0; p < this->total_processes; ++p)
+	{
+		everyone[p] = p;
+	}
+
+	this->exchange(send, everyone, send_counts, send_displs, recv, everyone, recv_counts, recv_displs, type);
+#endif
+}
+
+void large_count_comm::neighbor_alltoallv(const void *send, const std::vector<int> &destinations,
+                                          const std::vector<count_t> &send_counts,
+                                          const std::vector<count_t> &send_displs,
+                                          void *recv, const std::vector<int> &sources,
+                                          const std::vector<count_t> &recv_counts,
+                                          const std::vector<count_t> &recv_displs, const MPI_Datatype type) const
+{
+#if MPI_VERSION < 4
+	// Point to point between the listed processes already is the sparse exchange
+	if (!this->small)
+	{
+		this->exchange(send, destinations, send_counts, send_displs, recv, sources, recv_counts, recv_displs, type);
+		return;
+	}
+#endif
+
+	MPI_Comm neighbors;
+	MPI_Dist_graph_create_adjacent(this->comm,
+	                               static_cast<int>(sources.size()), sources.data(), MPI_UNWEIGHTED,
+	                               static_cast<int>(destinations.size()), destinations.data(), MPI_UNWEIGHTED,
+	                               MPI_INFO_NULL, 0, &neighbors);
+
+#if MPI_VERSION >= 4
+	MPI_Neighbor_alltoallv_c(send, to_counts(send_counts).data(), to_displs(send_displs).data(), type,
+	                         recv, to_counts(recv_counts).data(), to_displs(recv_displs).data(), type,
+	                         neighbors);
+#else
+	MPI_Neighbor_alltoallv(send, to_int(send_counts).data(), to_int(send_displs).data(), type,
+	                       recv, to_int(recv_counts).data(), to_int(recv_displs).data(), type,
+	                       neighbors);
+#endif
+
+	MPI_Comm_free(&neighbors);
+}
+
+int large_count_comm::read_at_all(const MPI_File file, const MPI_Offset offset, void *buffer, const count_t count,
+                                  const MPI_Datatype type)
+{
+	MPI_Status status;
+
+#if MPI_VERSION >= 4
+	return MPI_File_read_at_all_c(file, offset, buffer, count, type, &status);
+#else
+	// File collectives allow a different datatype on every process, so no common decision is needed
+	if (count <= INT_LIMIT)
+	{
+		return MPI_File_read_at_all(file, offset, buffer, static_cast<int>(count), type, &status);
+	}
+
+	auto large = create_type(count, type);
+	auto result = MPI_File_read_at_all(file, offset, buffer, 1, large, &status);
+	MPI_Type_free(&large);
+	return result;
+#endif
+}
+
+int large_count_comm::write_at_all(const MPI_File file, const MPI_Offset offset, const void *buffer,
+                                   const count_t count, const MPI_Datatype type)
+{
+	MPI_Status status;
+
+#if MPI_VERSION >= 4
+	return MPI_File_write_at_all_c(file, offset, buffer, count, type, &status);
+#else
+	if (count <= INT_LIMIT)
+	{
+		return MPI_File_write_at_all(file, offset, buffer, static_cast<int>(count), type, &status);
+	}
+
+	auto large = create_type(count, type);
+	auto result = MPI_File_write_at_all(file, offset, buffer, 1, large, &status);
+	MPI_Type_free(&large);
+	return result;
+#endif
+}
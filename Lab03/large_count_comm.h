@@ -0,0 +1,62 @@
+#ifndef LAB03_LARGE_COUNT_COMM_H
+#define LAB03_LARGE_COUNT_COMM_H
+
+#include <mpi.h>
+#include <vector>
+
+// Collectives and file access whose counts and displacements may go beyond INT_MAX elements.
+// MPI-4 libraries get the _c calls. Older ones keep the plain int calls while the bound given
+// at construction fits into int; beyond it every part travels point to point as one element
+// of a derived datatype made of INT_MAX-element chunks.
+class large_count_comm
+{
+public:
+	typedef long long count_t;
+private:
+	static const int TAG;
+	static const count_t INT_LIMIT;
+
+	const MPI_Comm comm;
+	// The bound is known to every process, so all of them take the same path of a collective
+	const bool small;
+	int process_id;
+	int total_processes;
+
+	static std::vector<int> to_int(const std::vector<count_t> &values);
+#if MPI_VERSION >= 4
+	static std::vector<MPI_Count> to_counts(const std::vector<count_t> &values);
+	static std::vector<MPI_Aint> to_displs(const std::vector<count_t> &values);
+#endif
+	void exchange(const void *send, const std::vector<int> &destinations, const std::vector<count_t> &send_counts,
+	              const std::vector<count_t> &send_displs,
+	              void *recv, const std::vector<int> &sources, const std::vector<count_t> &recv_counts,
+	              const std::vector<count_t> &recv_displs, const MPI_Datatype type) const;
+public:
+	// bound is the largest count or displacement any call of this object can see
+	large_count_comm(const MPI_Comm comm, const unsigned long long bound);
+
+	// A committed type of count consecutive elements of type, to be freed by the caller
+	static MPI_Datatype create_type(const count_t count, const MPI_Datatype type);
+
+	void scatterv(const void *send, const std::vector<count_t> &counts, const std::vector<count_t> &displs,
+	              void *recv, const count_t recv_count, const MPI_Datatype type, const int root) const;
+	void gatherv(const void *send, const count_t send_count,
+	             void *recv, const std::vector<count_t> &counts, const std::vector<count_t> &displs,
+	             const MPI_Datatype type, const int root) const;
+	void alltoallv(const void *send, const std::vector<count_t> &send_counts, const std::vector<count_t> &send_displs,
+	               void *recv, const std::vector<count_t> &recv_counts, const std::vector<count_t> &recv_displs,
+	               const MPI_Datatype type) const;
+	// Only the listed processes exchange, over a graph communicator built from them
+	void neighbor_alltoallv(const void *send, const std::vector<int> &destinations,
+	                        const std::vector<count_t> &send_counts, const std::vector<count_t> &send_displs,
+	                        void *recv, const std::vector<int> &sources,
+	                        const std::vector<count_t> &recv_counts, const std::vector<count_t> &recv_displs,
+	                        const MPI_Datatype type) const;
+
+	static int read_at_all(const MPI_File file, const MPI_Offset offset, void *buffer, const count_t count,
+	                       const MPI_Datatype type);
+	static int write_at_all(const MPI_File file, const MPI_Offset offset, const void *buffer, const count_t count,
+	                        const MPI_Datatype type);
+};
+
+#endif //LAB03_LARGE_COUNT_COMM_H
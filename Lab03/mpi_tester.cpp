@@ -1,19 +1,53 @@
 #include <mpi.h>
-#include <queue>
+#include <cmath>
 #include <chrono>
 #include <random>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cstring>
 #include <iterator>
+#include <algorithm>
 #include "mpi_tester.h"
 #include <iomanip>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
 
 
 const std::string mpi_tester::DEFAULT_OUTPUT_FILE_NAME = "output.txt";
 const std::string mpi_tester::USE_GENERATED_VECTOR_ARG = "-g";
 const std::string mpi_tester::OUTPUT_FILE_ARG = "-o";
 const std::string mpi_tester::VERBOSE_ARG = "-v";
+const std::string mpi_tester::SORT_ENGINE_ARG = "-sort";
+const std::string mpi_tester::RADIX_SORT = "radix";
+const std::string mpi_tester::STD_SORT = "std";
+const std::string mpi_tester::QSORT_SORT = "qsort";
+const std::string mpi_tester::THREADS_NUMBER_ARG = "-t";
+const std::string mpi_tester::OVERSAMPLING_ARG = "-oversampling";
+const std::string mpi_tester::EXCHANGE_ARG = "-exchange";
+const std::string mpi_tester::ALLTOALL_EXCHANGE = "alltoall";
+const std::string mpi_tester::NEIGHBOR_EXCHANGE = "neighbor";
+const std::string mpi_tester::WRITE_MODE_ARG = "-write";
+const std::string mpi_tester::ROOT_WRITE = "root";
+const std::string mpi_tester::TEXT_WRITE = "text";
+const std::string mpi_tester::BINARY_WRITE = "binary";
+const std::string mpi_tester::KEEP_WRITE = "keep";
+const std::string mpi_tester::READ_MODE_ARG = "-read";
+const std::string mpi_tester::ROOT_READ = "root";
+const std::string mpi_tester::TEXT_READ = "text";
+const std::string mpi_tester::BINARY_READ = "binary";
+const std::string mpi_tester::RECORDS_ARG = "-records";
+const std::string mpi_tester::NO_RECORDS = "none";
+const std::string mpi_tester::FULL_RECORDS = "full";
+const std::string mpi_tester::KEY_INDEX_RECORDS = "keyindex";
+const size_t mpi_tester::MAX_NUMBER_LENGTH = 32;
 const int mpi_tester::ROOT_ID = 0;
 
 template <typename T>
@@ -56,6 +90,13 @@ std::string mpi_tester::get_help()
 	ss << "Usage: Lab03 "
 		<< "[" << OUTPUT_FILE_ARG << " output_path] "
 		<< "[" << USE_GENERATED_VECTOR_ARG << " size] "
+		<< "[" << SORT_ENGINE_ARG << " " << RADIX_SORT << "|" << STD_SORT << "|" << QSORT_SORT << "] "
+		<< "[" << THREADS_NUMBER_ARG << " threads_number] "
+		<< "[" << OVERSAMPLING_ARG << " factor] "
+		<< "[" << EXCHANGE_ARG << " " << ALLTOALL_EXCHANGE << "|" << NEIGHBOR_EXCHANGE << "] "
+		<< "[" << READ_MODE_ARG << " " << ROOT_READ << "|" << TEXT_READ << "|" << BINARY_READ << "] "
+		<< "[" << WRITE_MODE_ARG << " " << ROOT_WRITE << "|" << TEXT_WRITE << "|" << BINARY_WRITE << "|" << KEEP_WRITE << "] "
+		<< "[" << RECORDS_ARG << " " << NO_RECORDS << "|" << FULL_RECORDS << "|" << KEY_INDEX_RECORDS << "] "
 		<< "input_file";
 	return ss.str();
 }
@@ -120,41 +161,199 @@ void mpi_tester::read_vector()
 	this->size = this->data.size();
 }
 
-void mpi_tester::fill_vector_randomly(std::vector<type_t> &v, const size_t size, random<type_t> &rnd)
+MPI_File mpi_tester::open_input_file(MPI_Offset &file_size) const
+{
+	MPI_File file;
+	if (MPI_File_open(MPI_COMM_WORLD, this->input_file.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+	{
+		throw std::invalid_argument("Can't read from file " + input_file + "!");
+	}
+
+	MPI_File_get_size(file, &file_size);
+	return file;
+}
+
+template <typename T>
+void mpi_tester::read_binary_part(std::vector<T> &values)
+{
+	MPI_Offset file_size;
+	auto file = open_input_file(file_size);
+
+	if (file_size % sizeof(T) != 0)
+	{
+		MPI_File_close(&file);
+		throw std::invalid_argument("Binary input size is not a multiple of the element size: " + input_file + "!");
+	}
+
+	this->size = static_cast<size_t>(file_size) / sizeof(T);
+	log("Total data size: ", this->size);
+	calculate_data_distribution();
+
+	auto count = this->elems_distribution[this->process_id];
+	values.resize(count);
+
+	large_count_comm::read_at_all(file,
+	                              static_cast<MPI_Offset>(this->positions_distribution[this->process_id] * sizeof(T)),
+	                              values.data(), count, mpi_datatype<T>::get());
+	MPI_File_close(&file);
+}
+
+bool mpi_tester::parse_number(const char *first, const char *last, type_t &value)
+{
+	// strtoll and streams spend most of the text input time, so the decimal is parsed by hand
+	auto negative = *first == '-';
+	if (*first == '-' || *first == '+')
+	{
+		++first;
+	}
+	if (first == last)
+	{
+		return false;
+	}
+
+	const auto limit = static_cast<unsigned long long>(std::numeric_limits<type_t>::max()) + (negative ? 1 : 0);
+	unsigned long long magnitude = 0;
+	for (; first != last; ++first)
+	{
+		if (*first < '0' || *first > '9')
+		{
+			return false;
+		}
+		auto digit = static_cast<unsigned long long>(*first - '0');
+		if (magnitude > (limit - digit) / 10)
+		{
+			return false;
+		}
+		magnitude = magnitude * 10 + digit;
+	}
+
+	value = negative ? static_cast<type_t>(0ULL - magnitude) : static_cast<type_t>(magnitude);
+	return true;
+}
+
+void mpi_tester::read_text_part()
+{
+	MPI_Offset file_size;
+	auto file = open_input_file(file_size);
+
+	// A number belongs to the process whose byte range holds its first character. The range is read
+	// with the byte before it, to see whether the first number started earlier, and with enough bytes
+	// after it to finish the last number
+	auto total = static_cast<unsigned long long>(file_size);
+	auto first = total * this->process_id / this->total_processes;
+	auto last = total * (this->process_id + 1) / this->total_processes;
+	auto read_from = first > 0 ? first - 1 : 0;
+	auto read_to = std::min<unsigned long long>(last + MAX_NUMBER_LENGTH, total);
+
+	std::string text(read_to - read_from, ' ');
+	large_count_comm::read_at_all(file, static_cast<MPI_Offset>(read_from), &text[0],
+	                              static_cast<count_t>(text.size()), MPI_CHAR);
+	MPI_File_close(&file);
+
+	auto is_space = [](const char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };
+	auto owned_end = last - read_from;
+	size_t position = first - read_from;
+
+	// The tail of a number started by the previous process
+	if (first > 0 && !is_space(text[0]))
+	{
+		while (position < text.size() && !is_space(text[position]))
+		{
+			++position;
+		}
+	}
+
+	while (true)
+	{
+		while (position < owned_end && is_space(text[position]))
+		{
+			++position;
+		}
+		if (position >= owned_end)
+		{
+			break;
+		}
+
+		auto start = position;
+		while (position < text.size() && !is_space(text[position]))
+		{
+			++position;
+		}
+		if (position == text.size() && read_to < total)
+		{
+			throw std::invalid_argument("Too long number in " + input_file + "!");
+		}
+
+		type_t value;
+		if (!parse_number(text.data() + start, text.data() + position, value))
+		{
+			throw std::invalid_argument("Can't parse number " + text.substr(start, position - start) +
+			                            " in " + input_file + "!");
+		}
+		this->data.push_back(value);
+	}
+
+	// Counts differ from process to process, so the distribution is what was actually read
+	auto count = static_cast<count_t>(this->data.size());
+	this->elems_distribution.assign(this->total_processes, 0);
+	MPI_Allgather(&count, 1, mpi_count_t, this->elems_distribution.data(), 1, mpi_count_t, MPI_COMM_WORLD);
+
+	this->positions_distribution.assign(this->total_processes, 0);
+	for (auto i = 1; i < this->total_processes; ++i)
+	{
+		this->positions_distribution[i] = this->positions_distribution[i - 1] + this->elems_distribution[i - 1];
+	}
+	this->size = this->positions_distribution.back() + this->elems_distribution.back();
+	log("Total data size: ", this->size);
+
+	log_data_distribution();
+}
+
+void mpi_tester::fill_vector_randomly(std::vector<type_t> &v, const size_t size, random_generator<type_t> &rnd)
 {
 	v.reserve(size);
 
-	for (auto i = 0; i < size; ++i)
+	for (size_t i = 0; i < size; ++i)
 	{
 		v.push_back(rnd.next());
 	}
 }
 
+void mpi_tester::fill_records_randomly(std::vector<record> &v, const size_t size, random_generator<type_t> &rnd)
+{
+	v.resize(size);
+
+	// The payload repeats the key bytes, so a record that lost its payload on the way is easy to spot
+	for (auto &r : v)
+	{
+		r.key = rnd.next();
+		for (size_t i = 0; i < record::PAYLOAD_SIZE; ++i)
+		{
+			r.payload[i] = reinterpret_cast<const char*>(&r.key)[i % sizeof(r.key)];
+		}
+	}
+}
+
 void mpi_tester::calculate_data_distribution()
 {
-	auto div = std::div(static_cast<int>(this->size), this->total_processes);
-	this->elems_per_process = (div.rem ? div.quot + 1 : div.quot);
+	auto processes = static_cast<size_t>(this->total_processes);
+	this->elems_per_process = (this->size + processes - 1) / processes;
 
-	auto row = 0;
+	count_t row = 0;
 	for (auto i = 0; i < this->total_processes; ++i)
 	{
-		auto left = this->size - row;
-		auto current = static_cast<int>(std::min(left, this->elems_per_process));
+		auto left = this->size - static_cast<size_t>(row);
+		auto current = static_cast<count_t>(std::min(left, this->elems_per_process));
 		this->elems_distribution.push_back(current);
 		this->positions_distribution.push_back(row);
 		row += current;
 	}
 
-	if (this->process_id != this->ROOT_ID)
-	{
-		this->data.assign(this->size, 0);
-	}
-
-	this->pivot_buffer.assign(this->total_processes * this->total_processes, 0);
-	this->class_starts.assign(this->total_processes, 0);
-	this->class_lengths.assign(this->total_processes, 0);
-	this->sorted_data.assign(this->size, 0);
+	log_data_distribution();
+}
 
+void mpi_tester::log_data_distribution()
+{
 	log("Elems to process: ", this->elems_distribution[this->process_id]);
 	log("Elems position: ", this->positions_distribution[this->process_id]);
 }
@@ -164,25 +363,64 @@ void mpi_tester::init()
 	MPI_Comm_size(MPI_COMM_WORLD, &this->total_processes);
 	MPI_Comm_rank(MPI_COMM_WORLD, &this->process_id);
 
-	if (this->process_id == this->ROOT_ID)
+	if (this->use_gen_input)
+	{
+		// The size is known everywhere, so every process generates only its own part
+		log("Generating vector");
+		calculate_data_distribution();
+		this->rnd.seed(std::chrono::system_clock::now().time_since_epoch().count() + this->process_id);
+		if (this->records_mode == NO_RECORDS)
+		{
+			this->fill_vector_randomly(this->data, this->elems_distribution[this->process_id], this->rnd);
+			log(this->data);
+		}
+		else
+		{
+			this->fill_records_randomly(this->records, this->elems_distribution[this->process_id], this->rnd);
+			log(this->records);
+		}
+		this->start_time = MPI_Wtime();
+		return;
+	}
+
+	auto before = MPI_Wtime();
+
+	if (this->read_mode != ROOT_READ)
 	{
-		if (this->use_gen_input)
+		// Every process reads its own byte range, nothing is staged on the root
+		log("Reading vector part");
+		if (this->records_mode != NO_RECORDS)
+		{
+			read_binary_part(this->records);
+			log(this->records);
+		}
+		else if (this->read_mode == BINARY_READ)
 		{
-			log("Generating vector");
-			this->fill_vector_randomly(this->data, this->size, this->rnd);
+			read_binary_part(this->data);
 			log(this->data);
 		}
 		else
 		{
-			log("Reading vector");
-			this->read_vector();
+			read_text_part();
 			log(this->data);
 		}
 
+		this->start_time = MPI_Wtime();
+		this->input_time = this->start_time - before;
+		return;
+	}
+
+	if (this->process_id == this->ROOT_ID)
+	{
+		log("Reading vector");
+		this->read_vector();
+		log(this->data);
+
 		this->size = this->data.size();
 	}
 
 	this->start_time = MPI_Wtime();
+	this->input_time = this->start_time - before;
 
 	MPI_Bcast(&this->size, 1, MPI_UNSIGNED_LONG_LONG, this->ROOT_ID, MPI_COMM_WORLD);
 	log("Total data size: ", this->size);
@@ -212,6 +450,56 @@ mpi_tester::mpi_tester(const int argc, const char *const argv[])
 		{
 			this->verbose = true;
 		}
+		else if (current == this->SORT_ENGINE_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->sort_engine = std::string(argv[++i]);
+		}
+		else if (current == this->EXCHANGE_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->exchange_mode = std::string(argv[++i]);
+		}
+		else if (current == this->READ_MODE_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->read_mode = std::string(argv[++i]);
+		}
+		else if (current == this->WRITE_MODE_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->write_mode = std::string(argv[++i]);
+		}
+		else if (current == this->RECORDS_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->records_mode = std::string(argv[++i]);
+		}
+		else if (current == this->THREADS_NUMBER_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			auto threads = parse_size_t(argv[++i],
+			                            "Non-integer parameter passed as threads number! ",
+			                            "Too large value passed as threads number! ");
+			if (threads == 0)
+			{
+				throw std::invalid_argument("Threads number must be positive!");
+			}
+#ifdef _OPENMP
+			omp_set_num_threads(static_cast<int>(threads));
+#endif
+		}
+		else if (current == this->OVERSAMPLING_ARG)
+		{
+			check_arguments_available(argc, i, 1);
+			this->oversampling = parse_size_t(argv[++i],
+			                                  "Non-integer parameter passed as oversampling factor! ",
+			                                  "Too large value passed as oversampling factor! ");
+			if (this->oversampling == 0)
+			{
+				throw std::invalid_argument("Oversampling factor must be positive!");
+			}
+		}
 		else if (this->input_file == "")
 		{
 			this->input_file = current;
@@ -232,6 +520,44 @@ void mpi_tester::check_arguments() const
 	{
 		throw std::invalid_argument("File with vector to sort has not been passed!");
 	}
+
+	if (this->sort_engine != RADIX_SORT && this->sort_engine != STD_SORT && this->sort_engine != QSORT_SORT)
+	{
+		throw std::invalid_argument("Unknown local sort: " + this->sort_engine + "!");
+	}
+
+	if (this->exchange_mode != ALLTOALL_EXCHANGE && this->exchange_mode != NEIGHBOR_EXCHANGE)
+	{
+		throw std::invalid_argument("Unknown exchange: " + this->exchange_mode + "!");
+	}
+
+	if (this->write_mode != ROOT_WRITE && this->write_mode != TEXT_WRITE &&
+		this->write_mode != BINARY_WRITE && this->write_mode != KEEP_WRITE)
+	{
+		throw std::invalid_argument("Unknown write mode: " + this->write_mode + "!");
+	}
+
+	if (this->read_mode != ROOT_READ && this->read_mode != TEXT_READ && this->read_mode != BINARY_READ)
+	{
+		throw std::invalid_argument("Unknown read mode: " + this->read_mode + "!");
+	}
+
+	if (this->records_mode != NO_RECORDS && this->records_mode != FULL_RECORDS &&
+		this->records_mode != KEY_INDEX_RECORDS)
+	{
+		throw std::invalid_argument("Unknown records mode: " + this->records_mode + "!");
+	}
+
+	// Records have no text form, they are read and written as raw bytes only
+	if (this->records_mode != NO_RECORDS && !this->use_gen_input && this->read_mode != BINARY_READ)
+	{
+		throw std::invalid_argument("Records are either generated or read with " + READ_MODE_ARG + " " + BINARY_READ + "!");
+	}
+	if (this->records_mode != NO_RECORDS && this->write_mode != BINARY_WRITE && this->write_mode != KEEP_WRITE)
+	{
+		throw std::invalid_argument("Records are written with " + WRITE_MODE_ARG + " " + BINARY_WRITE + " or " +
+		                            KEEP_WRITE + " only!");
+	}
 }
 
 void mpi_tester::print_process_id() const
@@ -249,186 +575,193 @@ bool mpi_tester::is_root() const
 
 void mpi_tester::scatter_data()
 {
+	if (this->use_gen_input || this->read_mode != ROOT_READ)
+	{
+		return;
+	}
+
 	log("Splitting data");
+	large_count_comm large_comm(MPI_COMM_WORLD, this->size);
 
 	if (is_root())
 	{
-		MPI_Scatterv(this->data.data(), this->elems_distribution.data(), this->positions_distribution.data(), mpi_type_t,
-		             MPI_IN_PLACE, this->elems_distribution[this->process_id], mpi_type_t,
-		             this->ROOT_ID, MPI_COMM_WORLD);
+		large_comm.scatterv(this->data.data(), this->elems_distribution, this->positions_distribution,
+		                    MPI_IN_PLACE, this->elems_distribution[this->process_id], mpi_datatype<type_t>::get(), this->ROOT_ID);
+
+		// The root part is the head of the input, the rest is not needed any more
+		this->data.resize(this->elems_distribution[this->process_id]);
+		this->data.shrink_to_fit();
 	}
 	else
 	{
-		MPI_Scatterv(nullptr, this->elems_distribution.data(), this->positions_distribution.data(), mpi_type_t,
-		             const_cast<long long*>(this->data.data()), this->elems_distribution[this->process_id], mpi_type_t,
-		             this->ROOT_ID, MPI_COMM_WORLD);
+		this->data.assign(this->elems_distribution[this->process_id], 0);
+		large_comm.scatterv(nullptr, this->elems_distribution, this->positions_distribution,
+		                    this->data.data(), this->elems_distribution[this->process_id], mpi_datatype<type_t>::get(), this->ROOT_ID);
 	}
 
 	log("Local data: ", this->data);
 }
 
-void mpi_tester::local_sort()
+template <typename T, typename KeyOf>
+void mpi_tester::sort_data(std::vector<T> &values)
 {
+	typedef sample_sorter<T, KeyOf> sorter_t;
+	sorter_t sorter(MPI_COMM_WORLD, this->size, this->oversampling);
+
 	log("Soring local parts");
-	qsort(this->data.data(), this->elems_distribution[this->process_id], sizeof(type_t), [](const void *a, const void *b)
-	      {
-		      auto arg1 = *static_cast<const type_t*>(a);
-		      auto arg2 = *static_cast<const type_t*>(b);
 
-		      if (arg1 < arg2) return -1;
-		      if (arg1 > arg2) return 1;
-		      return 0;
-	      });
-}
+	auto before = MPI_Wtime();
 
-void mpi_tester::collect_regular_samples()
-{
-	log("Calculating pivots");
-
-	for (auto i = 0; i < this->total_processes; ++i)
+	if (this->sort_engine == RADIX_SORT)
+	{
+		sorter_t::radix_sort(values);
+	}
+	else if (this->sort_engine == STD_SORT)
 	{
-		this->pivot_buffer[i] = this->data[i * this->elems_distribution[this->process_id] / this->total_processes];
+		sorter_t::std_sort(values);
+	}
+	else
+	{
+		sorter_t::qsort_sort(values);
 	}
 
-	log("Pivots: ", this->pivot_buffer);
-}
+	this->local_sort_time = MPI_Wtime() - before;
 
-void mpi_tester::gather_samples()
-{
-	log("Gathering pivots");
+	log("Calculating pivots");
+	sorter.choose_pivots(values);
+	log("Pivots after multimerge: ", sorter.get_pivots());
 
-	if (is_root())
+	log("Partitioning local data");
+	sorter.partition(values);
+
+	log("Exchanging classes between processes");
+	before = MPI_Wtime();
+
+	this->last_start = sorter.exchange_counts();
+	std::vector<T> received(static_cast<size_t>(this->last_start)); // all members of ith class
+
+	auto counts_received = MPI_Wtime();
+	this->counts_exchange_time = counts_received - before;
+
+	if (this->exchange_mode == NEIGHBOR_EXCHANGE)
 	{
-		MPI_Gather(MPI_IN_PLACE, this->total_processes, mpi_type_t,
-		                       this->pivot_buffer.data(), this->total_processes, mpi_type_t,
-		                       this->ROOT_ID, MPI_COMM_WORLD);
+		sorter.exchange_with_neighbors(values, received);
 	}
 	else
 	{
-		MPI_Gather(this->pivot_buffer.data(), this->total_processes, mpi_type_t,
-		           nullptr, this->total_processes, mpi_type_t,
-		           this->ROOT_ID, MPI_COMM_WORLD);
+		sorter.exchange(values, received);
 	}
 
-	log("Pivots after gather: ", this->pivot_buffer);
-}
+	this->data_exchange_time = MPI_Wtime() - counts_received;
 
-void mpi_tester::merge_samples()
-{
-	log("Multimerge samples");
-
-	if (is_root())
-	{
-		std::vector<std::vector<type_t>> samples(this->total_processes);
+	// The local classes are all sent, so only the received ones and the merge output stay alive
+	std::vector<T>().swap(values);
 
-		for (auto i = 0; i < this->total_processes; ++i)
-		{
-			samples[i] = std::vector<type_t>(&pivot_buffer[i * this->total_processes],
-			                                 &pivot_buffer[i * this->total_processes] + this->total_processes);
-		}
+	log("Local classes after exchange: ", received);
+	log("Multimerge classes");
 
-		std::vector<type_t> result(this->total_processes * this->total_processes, 0);
-		multimerge(samples, result);
+	before = MPI_Wtime();
+	values.resize(received.size());
+	sorter.merge(received, values);
+	this->merge_time = MPI_Wtime() - before;
 
-		for (auto i = 0; i < this->total_processes - 1; ++i)
-		{
-			this->pivot_buffer[i] = result[(i + 1) * this->total_processes];
-		}
-	}
+	log("Local data after multimerge: ", values);
 }
 
-void mpi_tester::broadcast_samples()
+void mpi_tester::sort_by_key_index()
 {
-	log("Broadcasting pivots");
+	// Only the keys and the input positions are sorted; the payloads stay where they were read
+	std::vector<key_index> keys(this->records.size());
+	auto first = this->positions_distribution[this->process_id];
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		keys[i].key = this->records[i].key;
+		keys[i].index = first + static_cast<count_t>(i);
+	}
 
-	MPI_Bcast(this->pivot_buffer.data(), this->total_processes - 1, mpi_type_t, this->ROOT_ID, MPI_COMM_WORLD);
+	sort_data<key_index, member_key<key_index>>(keys);
 
-	log("Pivots after multimerge: ", this->pivot_buffer);
+	auto before = MPI_Wtime();
+	permute_payloads(keys);
+	this->permute_time = MPI_Wtime() - before;
 }
 
-void mpi_tester::partition_local_data()
+void mpi_tester::permute_payloads(const std::vector<key_index> &keys)
 {
-	// All processes partition their data members based on the pivot values stored in pivotbuffer[]
-	// Partition information for data: 
-	// index of beginning of ith class is class_starts[i],
-	// length of ith class is class_lengths[i], and
-	// members of ith class, data[j], have the property pivot_buffer[i-1] <= data[j] < pivot_buffer[i]
-
-	log("Partitioning local data");
+	log("Permuting payloads");
 
-	auto dataindex = 0;
-	for (auto classindex = 0; classindex < this->total_processes - 1; ++classindex)
+	// The process that read a record is the last one whose part starts at or before its position
+	auto owner_of = [this](const count_t index)
 	{
-		this->class_starts[classindex] = dataindex;
-		this->class_lengths[classindex] = 0;
+		return static_cast<int>(std::upper_bound(this->positions_distribution.begin(),
+		                                         this->positions_distribution.end(), index) -
+			this->positions_distribution.begin()) - 1;
+	};
 
-		// as long as dataindex refers to data in the current class
-		while ((dataindex < this->elems_distribution[this->process_id])
-			&& (this->data[dataindex] <= pivot_buffer[classindex]))
-		{
-			this->class_lengths[classindex]++;
-			dataindex++;
-		}
+	// Requests for the records go to their owners grouped by owner, in the order of the sorted keys
+	std::vector<count_t> request_counts(this->total_processes, 0), request_displs(this->total_processes, 0);
+	for (auto &k : keys)
+	{
+		++request_counts[owner_of(k.index)];
+	}
+	for (auto i = 1; i < this->total_processes; ++i)
+	{
+		request_displs[i] = request_displs[i - 1] + request_counts[i - 1];
 	}
-	// set start and length for last class
-	this->class_starts[this->total_processes - 1] = dataindex;
-	this->class_lengths[this->total_processes - 1] = this->elems_distribution[this->process_id] - dataindex;
-}
 
-void mpi_tester::gather_and_multimerge_data()
-{
-	log("Gathering classes between processed");
-	// All ith classes are gathered by ith process 
-	std::vector<type_t> recv_buffer(this->size, 0); // buffer to hold all members of ith class 
-	std::vector<int> recv_counts(this->total_processes, 0);
-	std::vector<int> displs(this->total_processes, 0);
+	std::vector<count_t> requests(keys.size());
+	auto next = request_displs;
+	for (auto &k : keys)
+	{
+		auto owner = owner_of(k.index);
+		requests[next[owner]++] = k.index - this->positions_distribution[owner];
+	}
 
-	for (auto process = 0; process < this->total_processes; ++process)
+	std::vector<count_t> serve_counts(this->total_processes, 0), serve_displs(this->total_processes, 0);
+	MPI_Alltoall(request_counts.data(), 1, mpi_count_t, serve_counts.data(), 1, mpi_count_t, MPI_COMM_WORLD);
+	for (auto i = 1; i < this->total_processes; ++i)
 	{
-		MPI_Gather(&this->class_lengths[process], 1, MPI_INT,
-		           recv_counts.data(), 1, MPI_INT,
-		           process, MPI_COMM_WORLD);
+		serve_displs[i] = serve_displs[i - 1] + serve_counts[i - 1];
+	}
 
-		if (this->process_id == process)
-		{
-			displs[0] = 0;
-			for (auto i = 1; i < this->total_processes; ++i)
-			{
-				displs[i] = displs[i - 1] + recv_counts[i - 1];
-			}
-		}
+	large_count_comm large_comm(MPI_COMM_WORLD, this->size);
+	std::vector<count_t> served(static_cast<size_t>(serve_displs.back() + serve_counts.back()));
+	large_comm.alltoallv(requests.data(), request_counts, request_displs,
+	                     served.data(), serve_counts, serve_displs, mpi_count_t);
+	std::vector<count_t>().swap(requests);
 
-		// each process gathers up all the members of the ith process classes from the other nodes
-		MPI_Gatherv(&this->data[class_starts[process]], class_lengths[process], mpi_type_t,
-		            recv_buffer.data(), recv_counts.data(), displs.data(), mpi_type_t,
-		            process, MPI_COMM_WORLD);
+	// Every record crosses the network once, straight to the process that holds its key
+	std::vector<record> replies(served.size());
+	for (size_t i = 0; i < served.size(); ++i)
+	{
+		replies[i] = this->records[served[i]];
 	}
+	std::vector<record>().swap(this->records);
 
-	log("Local classes after gathering: ", recv_buffer);
-	log("Multimerge classes");
-
-	this->last_start = displs[this->total_processes - 1] + recv_counts[this->total_processes - 1];
+	std::vector<record> received(keys.size());
+	large_comm.alltoallv(replies.data(), serve_counts, serve_displs,
+	                     received.data(), request_counts, request_displs, mpi_datatype<record>::get());
+	std::vector<record>().swap(replies);
 
-	std::vector<std::vector<type_t>> starts(this->total_processes);
-	for (auto i = 0; i < this->total_processes; i++)
+	this->records.resize(keys.size());
+	next = request_displs;
+	for (size_t i = 0; i < keys.size(); ++i)
 	{
-		starts[i] = std::vector<type_t>(recv_buffer.data() + displs[i], recv_buffer.data() + displs[i] + recv_counts[i]);
+		this->records[i] = received[next[owner_of(keys[i].index)]++];
 	}
 
-	multimerge(starts, this->data);
-
-	log("Local data after multimerge: ", this->data);
+	log("Local records after permutation: ", this->records);
 }
 
 void mpi_tester::collect_data()
 {
 	log("Collecting data");
 
-	std::vector<int> recv_count(this->total_processes);
-	std::vector<int> displs(this->total_processes);
+	std::vector<count_t> recv_count(this->total_processes);
+	std::vector<count_t> displs(this->total_processes);
 
-	MPI_Gather(&this->last_start, 1, MPI_INT,
-	           recv_count.data(), 1, MPI_INT,
+	MPI_Gather(&this->last_start, 1, mpi_count_t,
+	           recv_count.data(), 1, mpi_count_t,
 	           this->ROOT_ID, MPI_COMM_WORLD);
 
 	if (is_root())
@@ -438,11 +771,12 @@ void mpi_tester::collect_data()
 		{
 			displs[i] = displs[i - 1] + recv_count[i - 1];
 		}
+		this->sorted_data.assign(this->size, 0);
 	}
 
-	MPI_Gatherv(this->data.data(), this->last_start, mpi_type_t,
-	            this->sorted_data.data(), recv_count.data(), displs.data(), mpi_type_t,
-	            this->ROOT_ID, MPI_COMM_WORLD);
+	large_count_comm(MPI_COMM_WORLD, this->size).gatherv(this->data.data(), this->last_start,
+	                                                     this->sorted_data.data(), recv_count, displs,
+	                                                     mpi_datatype<type_t>::get(), this->ROOT_ID);
 
 	if (is_root())
 	{
@@ -450,64 +784,222 @@ void mpi_tester::collect_data()
 	}
 }
 
+void mpi_tester::calculate_global_offset()
+{
+	// Classes go to processes in key order, so the result starts where the data of the lower ranks ends
+	auto count = static_cast<unsigned long long>(this->last_start);
+	MPI_Exscan(&count, &this->global_offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+	if (is_root())
+	{
+		this->global_offset = 0;
+	}
+
+	log("Global offset: ", this->global_offset);
+}
+
+void mpi_tester::write_output() const
+{
+	if (this->write_mode == ROOT_WRITE)
+	{
+		if (is_root())
+		{
+			print_answer();
+		}
+	}
+	else if (this->write_mode == BINARY_WRITE && this->records_mode != NO_RECORDS)
+	{
+		write_file(this->records.data(), this->last_start, mpi_datatype<record>::get(),
+		           this->global_offset * sizeof(record), this->size * sizeof(record));
+	}
+	else if (this->write_mode == BINARY_WRITE)
+	{
+		write_file(this->data.data(), this->last_start, mpi_datatype<type_t>::get(), this->global_offset * sizeof(type_t),
+		           this->size * sizeof(type_t));
+	}
+	else if (this->write_mode == TEXT_WRITE)
+	{
+		// Every process formats its own part the way print_answer does and the parts are laid one after another
+		auto text = format_text(this->data);
+
+		auto length = static_cast<unsigned long long>(text.size());
+		unsigned long long offset = 0, total = 0;
+		MPI_Exscan(&length, &offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+		MPI_Allreduce(&length, &total, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+		write_file(text.data(), static_cast<count_t>(length), MPI_CHAR, is_root() ? 0 : offset, total);
+	}
+}
+
+std::string mpi_tester::format_text(const std::vector<type_t> &values)
+{
+	std::string text;
+	text.reserve(values.size() * 21);
+
+	// Digits are put backwards from the end of the buffer; streams and printf are several times slower here
+	char digits[24];
+	auto end = digits + sizeof(digits);
+	for (auto i : values)
+	{
+		auto value = i < 0 ? 0ULL - static_cast<unsigned long long>(i) : static_cast<unsigned long long>(i);
+		auto position = end;
+		*--position = ' ';
+		do
+		{
+			*--position = static_cast<char>('0' + value % 10);
+			value /= 10;
+		}
+		while (value);
+		if (i < 0)
+		{
+			*--position = '-';
+		}
+		text.append(position, end);
+	}
+
+	return text;
+}
+
+void mpi_tester::write_file(const void *buffer, const count_t count, const MPI_Datatype type,
+                            const unsigned long long offset, const unsigned long long total_size) const
+{
+	MPI_File file;
+	if (MPI_File_open(MPI_COMM_WORLD, this->output_file.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY,
+	                  MPI_INFO_NULL, &file) != MPI_SUCCESS)
+	{
+		throw std::runtime_error("Output file does not exist or not ready to read: " + this->output_file);
+	}
+
+	// A longer file left from an earlier run is cut to the new size
+	MPI_File_set_size(file, static_cast<MPI_Offset>(total_size));
+
+	auto result = large_count_comm::write_at_all(file, static_cast<MPI_Offset>(offset), buffer, count, type);
+	MPI_File_close(&file);
+
+	if (result != MPI_SUCCESS)
+	{
+		throw std::runtime_error("Can't write to output file " + this->output_file + "!");
+	}
+}
+
 void mpi_tester::process()
 {
 	scatter_data();
-	local_sort();
-	collect_regular_samples();
-	gather_samples();
-	merge_samples();
-	broadcast_samples();
-	partition_local_data();
-	gather_and_multimerge_data();
-	collect_data();
+
+	if (this->records_mode == FULL_RECORDS)
+	{
+		sort_data<record, member_key<record>>(this->records);
+	}
+	else if (this->records_mode == KEY_INDEX_RECORDS)
+	{
+		sort_by_key_index();
+	}
+	else
+	{
+		sort_data<type_t, identity_key<type_t>>(this->data);
+	}
+
+	if (this->write_mode == ROOT_WRITE)
+	{
+		collect_data();
+	}
+	else
+	{
+		calculate_global_offset();
+	}
 
 	this->end_time = MPI_Wtime();
 
+	write_output();
+	this->output_time = MPI_Wtime() - this->end_time;
+
+	print_phase_time("Input (" + this->read_mode + ")", this->input_time);
+	print_phase_time("Local sort (" + this->sort_engine + ")", this->local_sort_time);
+	print_phase_time("Exchange counts", this->counts_exchange_time);
+	print_phase_time("Exchange data (" + this->exchange_mode + ")", this->data_exchange_time);
+	print_phase_time("Multimerge", this->merge_time);
+	if (this->records_mode == KEY_INDEX_RECORDS)
+	{
+		print_phase_time("Permute payloads", this->permute_time);
+	}
+	print_phase_time("Output (" + this->write_mode + ")", this->output_time);
+	print_bucket_imbalance();
+	print_peak_memory();
+
 	if (is_root())
 	{
-		auto duration = this->end_time - this->start_time;
-		double seconds, millis, micros, fract;
-		fract = 1000 * std::modf(duration, &seconds);
-		fract = 1000 * std::modf(fract, &millis);
-		std::modf(fract, &micros);
-		std::cout << "Time taken: " 
-			<< seconds << "s "
-			<< millis << "ms "
-			<< micros << "mcs "
-			<< std::endl;
-		print_answer();
+		std::cout << "Time taken: " << format_time(this->end_time - this->start_time) << std::endl;
 	}
 }
 
-void mpi_tester::multimerge(std::vector<std::vector<type_t>> &starts, std::vector<type_t> &result) const
+std::string mpi_tester::format_time(const double duration)
 {
-	std::priority_queue<mm_data<type_t>> priorities;
+	double seconds, millis, micros, fract;
+	fract = 1000 * std::modf(duration, &seconds);
+	fract = 1000 * std::modf(fract, &millis);
+	std::modf(fract, &micros);
 
-	for (auto i = 0; i < this->total_processes; ++i)
+	std::stringstream ss;
+	ss << seconds << "s "
+		<< millis << "ms "
+		<< micros << "mcs ";
+	return ss.str();
+}
+
+void mpi_tester::print_phase_time(const std::string &phase, const double time) const
+{
+	// The slowest process is the one the others wait for
+	auto slowest = 0.0;
+	MPI_Reduce(&time, &slowest, 1, MPI_DOUBLE, MPI_MAX, this->ROOT_ID, MPI_COMM_WORLD);
+
+	if (is_root())
 	{
-		if (starts[i].size() > 0)
-		{
-			priorities.push(mm_data<type_t>(i, 0, starts[i][0]));
-		}
+		std::cout << phase << ": " << format_time(slowest) << std::endl;
 	}
+}
+
+void mpi_tester::print_bucket_imbalance() const
+{
+	// The largest class decides how long the merge and the output take, n/p is what it would be ideally
+	count_t largest = 0;
+	MPI_Reduce(&this->last_start, &largest, 1, mpi_count_t, MPI_MAX, this->ROOT_ID, MPI_COMM_WORLD);
 
-	// As long as priorities is not empty, pull off the top member (the smallest value from list i), 
-	// push it into the result, and place the next element from list i in the priority queue
-	auto result_index = 0; // index into the merged array
-	while (!priorities.empty() && (result_index < result.size()))
+	if (is_root() && this->size > 0)
 	{
-		// grab the smallest element, and remove it from the priority queue
-		auto elem = priorities.top();
-		priorities.pop();
+		auto ideal = static_cast<double>(this->size) / this->total_processes;
+		std::cout << "Max bucket / (n/p): " << std::fixed << std::setprecision(3) << largest / ideal
+			<< " (" << largest << " elements, oversampling " << this->oversampling << ")"
+			<< std::defaultfloat << std::endl;
+	}
+}
+
+size_t mpi_tester::get_peak_memory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize;
+#else
+	// ru_maxrss is in kilobytes on Linux
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
 
-		// insert this smallest element into the merged array
-		result[result_index++] = starts[elem.start_index][elem.index];
+void mpi_tester::print_peak_memory() const
+{
+	auto peak = static_cast<unsigned long long>(get_peak_memory());
+	std::vector<unsigned long long> peaks(this->total_processes);
+	MPI_Gather(&peak, 1, MPI_UNSIGNED_LONG_LONG, peaks.data(), 1, MPI_UNSIGNED_LONG_LONG, this->ROOT_ID, MPI_COMM_WORLD);
 
-		// if start[xxx.start_index] is not empty, place the next member into priority
-		if (starts[elem.start_index].size() > (elem.index + 1))
+	if (is_root())
+	{
+		std::cout << "Peak memory:";
+		for (auto i = 0; i < this->total_processes; ++i)
 		{
-			priorities.push(mm_data<type_t>(elem.start_index, elem.index + 1, starts[elem.start_index][elem.index + 1]));
+			std::cout << " [" << i << "] " << std::fixed << std::setprecision(1) << peaks[i] / 1048576.0 << "MB";
 		}
+		std::cout << std::defaultfloat << std::endl;
 	}
 }
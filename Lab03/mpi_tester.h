@@ -1,45 +1,91 @@
 #ifndef LAB03_MPI_TESTER_H
 #define LAB03_MPI_TESTER_H
 
-#define mpi_type_t MPI_LONG_LONG_INT
+#define mpi_count_t MPI_LONG_LONG_INT
 
+#include <mpi.h>
+#include <limits>
+#include <string>
 #include <vector>
 #include "random.h"
+#include "records.h"
+#include "sample_sort.h"
+#include "large_count_comm.h"
 
 class mpi_tester
 {
 	typedef int64_t type_t;
+	typedef large_count_comm::count_t count_t;
 
 	static const std::string DEFAULT_OUTPUT_FILE_NAME;
 	static const std::string USE_GENERATED_VECTOR_ARG;
 	static const std::string OUTPUT_FILE_ARG;
 	static const std::string VERBOSE_ARG;
+	static const std::string SORT_ENGINE_ARG;
+	static const std::string RADIX_SORT;
+	static const std::string STD_SORT;
+	static const std::string QSORT_SORT;
+	static const std::string THREADS_NUMBER_ARG;
+	static const std::string OVERSAMPLING_ARG;
+	static const std::string EXCHANGE_ARG;
+	static const std::string ALLTOALL_EXCHANGE;
+	static const std::string NEIGHBOR_EXCHANGE;
+	static const std::string WRITE_MODE_ARG;
+	static const std::string ROOT_WRITE;
+	static const std::string TEXT_WRITE;
+	static const std::string BINARY_WRITE;
+	static const std::string KEEP_WRITE;
+	static const std::string READ_MODE_ARG;
+	static const std::string ROOT_READ;
+	static const std::string TEXT_READ;
+	static const std::string BINARY_READ;
+	static const std::string RECORDS_ARG;
+	static const std::string NO_RECORDS;
+	static const std::string FULL_RECORDS;
+	static const std::string KEY_INDEX_RECORDS;
+	static const size_t MAX_NUMBER_LENGTH;
 	static const int ROOT_ID;
 
 	std::string input_file = "";
 	std::string output_file = "";
 	std::vector<type_t> data;
 	std::vector<type_t> sorted_data;
-	random<type_t> rnd{std::numeric_limits<type_t>::min(), std::numeric_limits<type_t>::max()};
+	std::vector<record> records;
+	random_generator<type_t> rnd{static_cast<double>(std::numeric_limits<type_t>::min()),
+	                            static_cast<double>(std::numeric_limits<type_t>::max())};
 	bool use_gen_input = false;
 	bool verbose = false;
+	std::string sort_engine = RADIX_SORT;
+	std::string exchange_mode = ALLTOALL_EXCHANGE;
+	std::string write_mode = ROOT_WRITE;
+	std::string read_mode = ROOT_READ;
+	std::string records_mode = NO_RECORDS;
+	size_t oversampling = 1;
 	size_t size = 0;
 	int process_id = 0;
 	int total_processes = 0;
-	int last_start = 0;
+	count_t last_start = 0;
+	unsigned long long global_offset = 0;
 	size_t elems_per_process = 0;
-	std::vector<int> elems_distribution;
-	std::vector<int> positions_distribution;
-	std::vector<int> class_starts;
-	std::vector<int> class_lengths;
-	std::vector<type_t> pivot_buffer;
-	size_t pivot_buffer_size;
+	std::vector<count_t> elems_distribution;
+	std::vector<count_t> positions_distribution;
 	double start_time, end_time;
+	double local_sort_time = 0;
+	double counts_exchange_time = 0;
+	double data_exchange_time = 0;
+	double merge_time = 0;
+	double output_time = 0;
+	double input_time = 0;
+	double permute_time = 0;
 
 	static std::string get_help();
-	static void fill_vector_randomly(std::vector<type_t> &v, const size_t size, random<type_t> &rnd);
+	static void fill_vector_randomly(std::vector<type_t> &v, const size_t size, random_generator<type_t> &rnd);
+	static void fill_records_randomly(std::vector<record> &v, const size_t size, random_generator<type_t> &rnd);
 	static void check_arguments_available(const int total, const int current, const int required);
 	static size_t parse_size_t(const char *value, const char *parse_error, const char *overflow_error);
+	static std::string format_time(const double duration);
+	static std::string format_text(const std::vector<type_t> &values);
+	static bool parse_number(const char *first, const char *last, type_t &value);
 
 	template <typename H, typename... T>
 	void log(std::stringstream &ss, H &p, T ... t) const;
@@ -48,43 +94,51 @@ class mpi_tester
 
 	bool is_root() const;
 	void scatter_data();
-	void local_sort();
-	void collect_regular_samples();
-	void gather_samples();
-	void merge_samples();
-	void broadcast_samples();
-	void partition_local_data();
+	template <typename T, typename KeyOf>
+	void sort_data(std::vector<T> &values);
+	void sort_by_key_index();
+	void permute_payloads(const std::vector<key_index> &keys);
 	void read_vector();
+	template <typename T>
+	void read_binary_part(std::vector<T> &values);
+	void read_text_part();
+	MPI_File open_input_file(MPI_Offset &file_size) const;
+	void log_data_distribution();
 	void check_arguments() const;
 	void print_answer() const;
 	void print_process_id() const;
+	void print_phase_time(const std::string &phase, const double time) const;
+	void print_peak_memory() const;
+	void print_bucket_imbalance() const;
+	static size_t get_peak_memory();
 	void log(std::stringstream &ss) const;
 	void calculate_data_distribution();
-	void gather_and_multimerge_data();
 	void collect_data();
-	void multimerge(std::vector<std::vector<type_t>> &starts, std::vector<type_t> &result) const;
+	void calculate_global_offset();
+	void write_output() const;
+	void write_file(const void *buffer, const count_t count, const MPI_Datatype type, const unsigned long long offset,
+	                const unsigned long long total_size) const;
 public:
 	mpi_tester(const int argc, const char * const argv[]);
 	void init();
 	void process();
-};
 
-template <typename T>
-struct mm_data
-{
-	int start_index;
-	int index;
-	T start_value;
+	// With the keep mode the sorted data stays distributed: every process holds
+	// the part of the result starting at its global offset
+	const std::vector<type_t> &get_local_data() const
+	{
+		return data;
+	}
 
-	explicit mm_data(int st = 0, int id = 0, T stv = 0) : start_index(st), index(id), start_value(stv)
+	const std::vector<record> &get_local_records() const
 	{
+		return records;
 	}
 
-	bool operator<(const mm_data &o) const
+	unsigned long long get_global_offset() const
 	{
-		return this->start_value > o.start_value;
+		return global_offset;
 	}
 };
 
-
 #endif //LAB03_MPI_TESTER_H
@@ -0,0 +1,225 @@
+#ifndef LAB03_MULTIWAY_MERGE_H
+#define LAB03_MULTIWAY_MERGE_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include "omp_threads.h"
+
+// Tournament tree of losers over k sorted runs. Every inner node keeps the run that lost
+// the match there and the root keeps the winner, so taking the next element only replays
+// the log(k) matches on the path of the run it came from. Equal elements are taken from
+// the lower run first.
+template <typename T, typename Less = std::less<T>>
+class loser_tree
+{
+public:
+	typedef std::pair<const T*, const T*> run_t;
+private:
+	size_t leaves;
+	std::vector<const T*> heads;
+	std::vector<const T*> ends;
+	std::vector<size_t> losers;
+	Less less;
+
+	// Exhausted runs lose to everything
+	bool beats(const size_t a, const size_t b) const
+	{
+		if (heads[a] == ends[a])
+		{
+			return false;
+		}
+		if (heads[b] == ends[b])
+		{
+			return true;
+		}
+		if (less(*heads[a], *heads[b]))
+		{
+			return true;
+		}
+		return !less(*heads[b], *heads[a]) && a < b;
+	}
+
+	size_t build(const size_t node)
+	{
+		if (node >= leaves)
+		{
+			return node - leaves;
+		}
+
+		auto left = build(2 * node);
+		auto right = build(2 * node + 1);
+		if (beats(left, right))
+		{
+			losers[node] = right;
+			return left;
+		}
+		losers[node] = left;
+		return right;
+	}
+public:
+	explicit loser_tree(const std::vector<run_t> &runs, Less less = Less()) : leaves(1),
+	                                                                           less(less)
+	{
+		while (leaves < runs.size())
+		{
+			leaves <<= 1;
+		}
+
+		// Missing leaves up to the power of two are empty runs
+		heads.assign(leaves, nullptr);
+		ends.assign(leaves, nullptr);
+		for (size_t i = 0; i < runs.size(); ++i)
+		{
+			heads[i] = runs[i].first;
+			ends[i] = runs[i].second;
+		}
+
+		losers.assign(leaves, 0);
+		losers[0] = build(1);
+	}
+
+	// Writes the next count elements of the merged runs
+	void merge(T *output, const size_t count)
+	{
+		for (size_t n = 0; n < count; ++n)
+		{
+			auto winner = losers[0];
+			output[n] = *heads[winner]++;
+
+			for (auto node = (winner + leaves) >> 1; node > 0; node >>= 1)
+			{
+				if (beats(losers[node], winner))
+				{
+					std::swap(losers[node], winner);
+				}
+			}
+			losers[0] = winner;
+		}
+	}
+};
+
+// k-way merge of sorted runs into one output. The output is cut into equal ranges, one per
+// OpenMP thread; the merge path of every cut (how many elements each run contributes before it)
+// is found by selection over the runs, and then the threads merge their ranges independently.
+template <typename T, typename Less = std::less<T>>
+class multiway_merger
+{
+public:
+	typedef typename loser_tree<T, Less>::run_t run_t;
+private:
+	// Below this many output elements per thread splitting costs more than it gives
+	static const size_t SMALL_SIZE = size_t(1) << 14;
+
+	// Positions in every run such that the elements before them are exactly the rank smallest ones,
+	// with equal elements split in the same run order the loser tree uses
+	static std::vector<size_t> split(const std::vector<run_t> &runs, const size_t rank, Less less)
+	{
+		auto k = runs.size();
+		std::vector<size_t> positions(k), low(k, 0), high(k);
+		size_t total = 0;
+
+		for (size_t i = 0; i < k; ++i)
+		{
+			high[i] = static_cast<size_t>(runs[i].second - runs[i].first);
+			total += high[i];
+		}
+
+		if (rank >= total)
+		{
+			return high;
+		}
+
+		// The element of the rank always stays inside the [low, high) windows, the widest of which
+		// is halved by every pivot taken from its middle
+		std::vector<size_t> lower(k), upper(k);
+		while (true)
+		{
+			size_t widest = 0;
+			for (size_t i = 1; i < k; ++i)
+			{
+				if (high[i] - low[i] > high[widest] - low[widest])
+				{
+					widest = i;
+				}
+			}
+
+			auto pivot = runs[widest].first[(low[widest] + high[widest]) / 2];
+			size_t below = 0, not_above = 0;
+			for (size_t i = 0; i < k; ++i)
+			{
+				lower[i] = std::lower_bound(runs[i].first, runs[i].second, pivot, less) - runs[i].first;
+				upper[i] = std::upper_bound(runs[i].first, runs[i].second, pivot, less) - runs[i].first;
+				below += lower[i];
+				not_above += upper[i];
+			}
+
+			if (rank < below)
+			{
+				for (size_t i = 0; i < k; ++i)
+				{
+					high[i] = std::min(high[i], lower[i]);
+				}
+			}
+			else if (rank >= not_above)
+			{
+				for (size_t i = 0; i < k; ++i)
+				{
+					low[i] = std::max(low[i], upper[i]);
+				}
+			}
+			else
+			{
+				auto equal = rank - below;
+				for (size_t i = 0; i < k; ++i)
+				{
+					auto taken = std::min(equal, upper[i] - lower[i]);
+					positions[i] = lower[i] + taken;
+					equal -= taken;
+				}
+				return positions;
+			}
+		}
+	}
+public:
+	static void merge(const std::vector<run_t> &runs, T *output, Less less = Less())
+	{
+		size_t total = 0;
+		for (auto &run : runs)
+		{
+			total += static_cast<size_t>(run.second - run.first);
+		}
+
+		auto threads = omp_threads::get_threads(total, SMALL_SIZE);
+		std::vector<std::vector<size_t>> cuts(threads + 1);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+		{
+			// Output is cut between the threads granted, which may be fewer than asked for
+			auto team = static_cast<size_t>(omp_threads::get_team_size());
+			auto thread = static_cast<size_t>(omp_threads::get_thread());
+			cuts[thread] = split(runs, total * thread / team, less);
+			if (thread + 1 == team)
+			{
+				cuts[team] = split(runs, total, less);
+			}
+
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+			std::vector<run_t> ranges(runs.size());
+			for (size_t i = 0; i < runs.size(); ++i)
+			{
+				ranges[i] = run_t(runs[i].first + cuts[thread][i], runs[i].first + cuts[thread + 1][i]);
+			}
+
+			auto first = total * thread / team;
+			loser_tree<T, Less>(ranges, less).merge(output + first, total * (thread + 1) / team - first);
+		}
+	}
+};
+
+#endif //LAB03_MULTIWAY_MERGE_H
@@ -0,0 +1,48 @@
+#ifndef LAB03_OMP_THREADS_H
+#define LAB03_OMP_THREADS_H
+
+#include <algorithm>
+#include <cstddef>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Thread queries of the sorters that also compile without OpenMP, where every region runs on one thread
+class omp_threads
+{
+public:
+	// Threads to ask for so that every one gets at least min_size of the size elements
+	static int get_threads(const size_t size, const size_t min_size)
+	{
+#ifdef _OPENMP
+		auto threads = static_cast<size_t>(omp_get_max_threads());
+		return static_cast<int>(std::max<size_t>(1, std::min(threads, size / min_size)));
+#else
+		(void)size;
+		(void)min_size;
+		return 1;
+#endif
+	}
+
+	static int get_thread()
+	{
+#ifdef _OPENMP
+		return omp_get_thread_num();
+#else
+		return 0;
+#endif
+	}
+
+	// Threads that actually run the current region; OpenMP may give fewer than num_threads asked for,
+	// e.g. under OMP_THREAD_LIMIT, so work inside the region must be split by this number
+	static int get_team_size()
+	{
+#ifdef _OPENMP
+		return omp_get_num_threads();
+#else
+		return 1;
+#endif
+	}
+};
+
+#endif //LAB03_OMP_THREADS_H
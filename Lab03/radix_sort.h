@@ -0,0 +1,114 @@
+#ifndef LAB03_RADIX_SORT_H
+#define LAB03_RADIX_SORT_H
+
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include "records.h"
+#include "omp_threads.h"
+
+// LSD radix sort of elements by the integer keys KeyOf extracts, DIGIT_BITS bits per pass. Signed
+// keys have their sign bit flipped so that the unsigned order matches the signed one. Every pass is
+// split between the OpenMP threads: each thread counts the digits of its chunk and then scatters the chunk
+// to its own offsets, which keeps the pass stable.
+template <typename T, typename KeyOf = identity_key<T>>
+class radix_sorter
+{
+	typedef typename KeyOf::key_t signed_key_t;
+	typedef typename std::make_unsigned<signed_key_t>::type key_t;
+
+	static const size_t DIGIT_BITS = 11;
+	static const size_t DIGITS = size_t(1) << DIGIT_BITS;
+	static const size_t PASSES = (sizeof(key_t) * 8 + DIGIT_BITS - 1) / DIGIT_BITS;
+	// Below this many elements per thread a comparison sort beats the passes over the buffers
+	static const size_t SMALL_SIZE = size_t(1) << 12;
+
+	static size_t get_digit(const T &value, const size_t pass)
+	{
+		auto key = static_cast<key_t>(KeyOf()(value));
+		if (std::is_signed<signed_key_t>::value)
+		{
+			key ^= key_t(1) << (sizeof(key_t) * 8 - 1);
+		}
+		return static_cast<size_t>(key >> (pass * DIGIT_BITS)) & (DIGITS - 1);
+	}
+public:
+	static void sort(T *data, const size_t size)
+	{
+		if (size < SMALL_SIZE)
+		{
+			std::sort(data, data + size, [](const T &a, const T &b) { return KeyOf()(a) < KeyOf()(b); });
+			return;
+		}
+
+		std::vector<T> buffer(size);
+		auto source = data;
+		auto target = buffer.data();
+		auto threads = omp_threads::get_threads(size, SMALL_SIZE);
+		std::vector<size_t> counts(threads * DIGITS);
+
+		for (size_t pass = 0; pass < PASSES; ++pass)
+		{
+			auto trivial = false;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+			{
+				// The chunks follow the threads granted, which may be fewer than asked for
+				auto team = static_cast<size_t>(omp_threads::get_team_size());
+				auto thread = static_cast<size_t>(omp_threads::get_thread());
+				auto first = size * thread / team;
+				auto last = size * (thread + 1) / team;
+				auto local = counts.data() + thread * DIGITS;
+
+				std::fill(local, local + DIGITS, 0);
+				for (auto i = first; i < last; ++i)
+				{
+					++local[get_digit(source[i], pass)];
+				}
+
+#ifdef _OPENMP
+#pragma omp barrier
+#pragma omp single
+#endif
+				{
+					// Offsets go digit by digit and thread by thread inside a digit
+					size_t offset = 0;
+					for (size_t digit = 0; digit < DIGITS; ++digit)
+					{
+						auto start = offset;
+						for (size_t t = 0; t < team; ++t)
+						{
+							auto count = counts[t * DIGITS + digit];
+							counts[t * DIGITS + digit] = offset;
+							offset += count;
+						}
+						// All keys share this digit, the pass would only copy them
+						trivial = trivial || offset - start == size;
+					}
+				}
+
+				if (!trivial)
+				{
+					for (auto i = first; i < last; ++i)
+					{
+						target[local[get_digit(source[i], pass)]++] = source[i];
+					}
+				}
+			}
+
+			if (!trivial)
+			{
+				std::swap(source, target);
+			}
+		}
+
+		if (source != data)
+		{
+			std::copy(source, source + size, data);
+		}
+	}
+};
+
+#endif //LAB03_RADIX_SORT_H
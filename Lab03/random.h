@@ -5,16 +5,21 @@
 #include <chrono>
 
 template <typename T>
-class random
+class random_generator
 {
 	std::default_random_engine gen;
 	std::uniform_real_distribution<double> dist;
 public:
-	random(double min, double max): gen(std::chrono::system_clock::now().time_since_epoch().count()),
-	                                dist(min, max)
+	random_generator(double min, double max): gen(std::chrono::system_clock::now().time_since_epoch().count()),
+	                                          dist(min, max)
 	{
 	}
 
+	void seed(const unsigned long long value)
+	{
+		gen.seed(static_cast<std::default_random_engine::result_type>(value));
+	}
+
 	T next()
 	{
 		return static_cast<T>(dist(gen));
@@ -0,0 +1,113 @@
+#ifndef LAB03_RECORDS_H
+#define LAB03_RECORDS_H
+
+#include <mpi.h>
+#include <cstdint>
+#include <ostream>
+
+// Key extractors: the sort orders elements by the integer they return
+template <typename T>
+struct identity_key
+{
+	typedef T key_t;
+
+	key_t operator()(const T &value) const
+	{
+		return value;
+	}
+};
+
+template <typename T>
+struct member_key
+{
+	typedef decltype(T::key) key_t;
+
+	key_t operator()(const T &value) const
+	{
+		return value.key;
+	}
+};
+
+// Fixed-size record with a 64-bit key and an opaque payload, 64 bytes in total
+struct record
+{
+	static const size_t PAYLOAD_SIZE = 56;
+
+	int64_t key;
+	char payload[PAYLOAD_SIZE];
+};
+
+// Stands in for a record while sorting: its key and its position in the input
+struct key_index
+{
+	int64_t key;
+	int64_t index;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const record &r)
+{
+	return os << r.key;
+}
+
+inline std::ostream &operator<<(std::ostream &os, const key_index &k)
+{
+	return os << k.key << ':' << k.index;
+}
+
+// MPI datatype of an element: the predefined one for integers, and for any other trivially
+// copyable type a contiguous run of its bytes, created and committed on first use
+template <typename T>
+struct mpi_datatype
+{
+	static MPI_Datatype get()
+	{
+		static auto type = create();
+		return type;
+	}
+private:
+	static MPI_Datatype create()
+	{
+		MPI_Datatype type;
+		MPI_Type_contiguous(static_cast<int>(sizeof(T)), MPI_BYTE, &type);
+		MPI_Type_commit(&type);
+		return type;
+	}
+};
+
+template <>
+struct mpi_datatype<int32_t>
+{
+	static MPI_Datatype get()
+	{
+		return MPI_INT32_T;
+	}
+};
+
+template <>
+struct mpi_datatype<int64_t>
+{
+	static MPI_Datatype get()
+	{
+		return MPI_INT64_T;
+	}
+};
+
+template <>
+struct mpi_datatype<uint32_t>
+{
+	static MPI_Datatype get()
+	{
+		return MPI_UINT32_T;
+	}
+};
+
+template <>
+struct mpi_datatype<uint64_t>
+{
+	static MPI_Datatype get()
+	{
+		return MPI_UINT64_T;
+	}
+};
+
+#endif //LAB03_RECORDS_H
@@ -0,0 +1,291 @@
+#ifndef LAB03_SAMPLE_SORT_H
+#define LAB03_SAMPLE_SORT_H
+
+#include <mpi.h>
+#include <vector>
+#include <cstdlib>
+#include <limits>
+#include <ostream>
+#include <algorithm>
+#include "records.h"
+#include "radix_sort.h"
+#include "multiway_merge.h"
+#include "large_count_comm.h"
+
+// Steps of the parallel sort by regular sampling of elements T ordered by the keys KeyOf extracts.
+// Every process sorts its part, the root picks p - 1 pivots out of s * p regular samples of every part
+// (s is the oversampling factor), and the classes the pivots cut the parts into are exchanged so that
+// process i merges the ith classes of all parts. Elements travel as mpi_datatype<T>, so any trivially
+// copyable record works.
+//
+// Samples and pivots are ordered by (key, process, position in the sorted local part), which tells
+// apart all elements, equal keys included. A run of equal keys longer than a class is therefore cut
+// between processes like any other run, and no class grows past about (1 + 1/s) n/p elements.
+template <typename T, typename KeyOf = identity_key<T>>
+class sample_sorter
+{
+public:
+	typedef typename KeyOf::key_t key_t;
+	typedef large_count_comm::count_t count_t;
+
+	struct splitter
+	{
+		key_t key;
+		count_t process;
+		count_t index;
+
+		bool operator<(const splitter &other) const
+		{
+			if (key != other.key)
+			{
+				return key < other.key;
+			}
+			if (process != other.process)
+			{
+				return process < other.process;
+			}
+			return index < other.index;
+		}
+
+		friend std::ostream &operator<<(std::ostream &os, const splitter &s)
+		{
+			return os << s.key << '@' << s.process << ':' << s.index;
+		}
+	};
+private:
+	struct key_less
+	{
+		bool operator()(const T &a, const T &b) const
+		{
+			return KeyOf()(a) < KeyOf()(b);
+		}
+	};
+
+	typedef multiway_merger<T, key_less> merger_t;
+	typedef typename merger_t::run_t run_t;
+	typedef typename multiway_merger<splitter>::run_t sample_run_t;
+
+	static const int ROOT_ID = 0;
+
+	const MPI_Comm comm;
+	const large_count_comm large_comm;
+	int process_id;
+	int total_processes;
+	const size_t oversampling;
+	size_t samples_per_process;
+	std::vector<splitter> pivots;
+	std::vector<count_t> class_starts;
+	std::vector<count_t> class_lengths;
+	std::vector<count_t> recv_counts;
+	std::vector<count_t> recv_displs;
+
+	// A process without data samples the largest key, so it never pulls the pivots down
+	void collect_regular_samples(const std::vector<T> &data)
+	{
+		this->pivots.resize(this->total_processes * this->samples_per_process);
+		for (size_t i = 0; i < this->samples_per_process; ++i)
+		{
+			auto index = i * data.size() / this->samples_per_process;
+			auto &sample = this->pivots[i];
+			sample.key = data.empty() ? std::numeric_limits<key_t>::max() : KeyOf()(data[index]);
+			sample.process = this->process_id;
+			sample.index = static_cast<count_t>(index);
+		}
+	}
+
+	void gather_samples()
+	{
+		auto type = mpi_datatype<splitter>::get();
+		auto count = static_cast<int>(this->samples_per_process);
+		if (this->process_id == ROOT_ID)
+		{
+			MPI_Gather(MPI_IN_PLACE, count, type, this->pivots.data(), count, type, ROOT_ID, this->comm);
+		}
+		else
+		{
+			MPI_Gather(this->pivots.data(), count, type, nullptr, count, type, ROOT_ID, this->comm);
+		}
+	}
+
+	// The samples of every process are sorted already, so the root merges them and takes every
+	// (s * p)th one
+	void merge_samples()
+	{
+		if (this->process_id != ROOT_ID)
+		{
+			return;
+		}
+
+		std::vector<sample_run_t> samples(this->total_processes);
+		for (auto i = 0; i < this->total_processes; ++i)
+		{
+			auto start = this->pivots.data() + i * this->samples_per_process;
+			samples[i] = sample_run_t(start, start + this->samples_per_process);
+		}
+
+		std::vector<splitter> result(this->pivots.size());
+		multiway_merger<splitter>::merge(samples, result.data());
+
+		for (auto i = 0; i < this->total_processes - 1; ++i)
+		{
+			this->pivots[i] = result[(i + 1) * this->samples_per_process];
+		}
+	}
+
+	void broadcast_samples()
+	{
+		this->pivots.resize(this->total_processes - 1);
+		MPI_Bcast(this->pivots.data(), this->total_processes - 1, mpi_datatype<splitter>::get(), ROOT_ID, this->comm);
+	}
+public:
+	// total_size is the number of elements on all processes together,
+	// oversampling is how many times more samples than processes every process gives
+	sample_sorter(const MPI_Comm comm, const unsigned long long total_size,
+	              const size_t oversampling = 1) : comm(comm),
+	                                               large_comm(comm, total_size),
+	                                               oversampling(oversampling)
+	{
+		MPI_Comm_rank(comm, &this->process_id);
+		MPI_Comm_size(comm, &this->total_processes);
+		this->samples_per_process = this->oversampling * this->total_processes;
+
+		this->class_starts.assign(this->total_processes, 0);
+		this->class_lengths.assign(this->total_processes, 0);
+		this->recv_counts.assign(this->total_processes, 0);
+		this->recv_displs.assign(this->total_processes, 0);
+	}
+
+	static void radix_sort(std::vector<T> &data)
+	{
+		radix_sorter<T, KeyOf>::sort(data.data(), data.size());
+	}
+
+	static void std_sort(std::vector<T> &data)
+	{
+		std::sort(data.begin(), data.end(), key_less());
+	}
+
+	static void qsort_sort(std::vector<T> &data)
+	{
+		qsort(data.data(), data.size(), sizeof(T), [](const void *a, const void *b)
+		      {
+			      auto arg1 = KeyOf()(*static_cast<const T*>(a));
+			      auto arg2 = KeyOf()(*static_cast<const T*>(b));
+
+			      if (arg1 < arg2) return -1;
+			      if (arg1 > arg2) return 1;
+			      return 0;
+		      });
+	}
+
+	// Collective; data is the sorted local part
+	void choose_pivots(const std::vector<T> &data)
+	{
+		collect_regular_samples(data);
+		gather_samples();
+		merge_samples();
+		broadcast_samples();
+	}
+
+	const std::vector<splitter> &get_pivots() const
+	{
+		return this->pivots;
+	}
+
+	// Class i of the sorted local part holds the elements whose (key, process, index)
+	// lies in (pivots[i - 1], pivots[i]]
+	void partition(const std::vector<T> &data)
+	{
+		auto key_less_value = [](const key_t &key, const T &value) { return key < KeyOf()(value); };
+		auto value_less_key = [](const T &value, const key_t &key) { return KeyOf()(value) < key; };
+
+		auto position = data.begin();
+		for (auto i = 0; i < this->total_processes - 1; ++i)
+		{
+			auto &pivot = this->pivots[i];
+			auto end = std::upper_bound(position, data.end(), pivot.key, key_less_value);
+
+			// Keys equal to the pivot one are split by process, and on the pivot's own process by position
+			if (pivot.process < this->process_id)
+			{
+				end = std::lower_bound(position, end, pivot.key, value_less_key);
+			}
+			else if (pivot.process == this->process_id)
+			{
+				auto equal = std::lower_bound(position, end, pivot.key, value_less_key) - data.begin();
+				auto split = std::min<count_t>(pivot.index + 1, end - data.begin());
+				end = data.begin() + std::max<count_t>(equal, split);
+			}
+
+			this->class_starts[i] = position - data.begin();
+			this->class_lengths[i] = end - position;
+			position = end;
+		}
+		this->class_starts[this->total_processes - 1] = position - data.begin();
+		this->class_lengths[this->total_processes - 1] = data.end() - position;
+	}
+
+	// Collective; returns how many elements this process is going to receive
+	count_t exchange_counts()
+	{
+		MPI_Alltoall(this->class_lengths.data(), 1, MPI_LONG_LONG_INT,
+		             this->recv_counts.data(), 1, MPI_LONG_LONG_INT, this->comm);
+
+		for (auto i = 1; i < this->total_processes; ++i)
+		{
+			this->recv_displs[i] = this->recv_displs[i - 1] + this->recv_counts[i - 1];
+		}
+		return this->recv_displs.back() + this->recv_counts.back();
+	}
+
+	// Classes are contiguous in the sorted local part, so they are sent in place
+	void exchange(const std::vector<T> &data, std::vector<T> &received) const
+	{
+		this->large_comm.alltoallv(data.data(), this->class_lengths, this->class_starts,
+		                           received.data(), this->recv_counts, this->recv_displs, mpi_datatype<T>::get());
+	}
+
+	// Only the processes that actually exchange classes become neighbours,
+	// so with skewed data most of the p^2 empty pairs are never touched
+	void exchange_with_neighbors(const std::vector<T> &data, std::vector<T> &received) const
+	{
+		std::vector<int> sources, destinations;
+		std::vector<count_t> source_counts, source_displs;
+		std::vector<count_t> destination_counts, destination_displs;
+
+		for (auto process = 0; process < this->total_processes; ++process)
+		{
+			if (this->recv_counts[process] > 0)
+			{
+				sources.push_back(process);
+				source_counts.push_back(this->recv_counts[process]);
+				source_displs.push_back(this->recv_displs[process]);
+			}
+			if (this->class_lengths[process] > 0)
+			{
+				destinations.push_back(process);
+				destination_counts.push_back(this->class_lengths[process]);
+				destination_displs.push_back(this->class_starts[process]);
+			}
+		}
+
+		this->large_comm.neighbor_alltoallv(data.data(), destinations, destination_counts, destination_displs,
+		                                    received.data(), sources, source_counts, source_displs,
+		                                    mpi_datatype<T>::get());
+	}
+
+	// The received classes are merged where they are into result, which must be as long as received
+	void merge(const std::vector<T> &received, std::vector<T> &result) const
+	{
+		std::vector<run_t> runs(this->total_processes);
+		for (auto i = 0; i < this->total_processes; ++i)
+		{
+			auto start = received.data() + this->recv_displs[i];
+			runs[i] = run_t(start, start + this->recv_counts[i]);
+		}
+
+		merger_t::merge(runs, result.data());
+	}
+};
+
+#endif //LAB03_SAMPLE_SORT_H
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""Strong and weak scaling sweeps of the Lab02 Jacobi solver and the Lab03 sample sort on one machine.
+
+Builds the lab with mpicxx, runs every (processes, size) configuration several times and writes
+one CSV row per configuration with the timings, speedup and parallel efficiency against 1 process.
+
+Examples:
+    python3 benchmark.py lab02 --mode strong --np 1 2 4 --sizes 500 1000 --trials 5
+    python3 benchmark.py lab02 lab03 --mode weak --np 1 2 4 8 --sizes 1000 --mpi-args=--oversubscribe
+"""
+
+import argparse
+import csv
+import math
+import os
+import re
+import statistics
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+
+LABS = {
+    'lab02': {
+        'sources': 'Lab02',
+        'flags': ['-fopenmp'],
+        # Jacobi costs n^2 / p per iteration, so the weak sweep keeps n^2 / p constant
+        'weak_size': lambda size, np: int(round(size * math.sqrt(np))),
+        'default_args': ['-gt', 'dominant'],
+    },
+    'lab03': {
+        'sources': 'Lab03',
+        'flags': ['-fopenmp'],
+        'weak_size': lambda size, np: size * np,
+        'default_args': [],
+    },
+}
+
+LAB02_TIME = re.compile(r'Time taken: ([0-9.]+)ms')
+LAB02_SOLVER = re.compile(r'Solver: \S+, converged: \w+, iterations: (\d+), time: ([0-9.eE+-]+)ms')
+LAB03_TIME = re.compile(r'Time taken: (\d+)s (\d+)ms (\d+)mcs')
+
+
+def build(lab, build_dir, compiler):
+    config = LABS[lab]
+    source_dir = os.path.join(ROOT, config['sources'])
+    sources = sorted(os.path.join(source_dir, name) for name in os.listdir(source_dir) if name.endswith('.cpp'))
+    binary = os.path.join(build_dir, lab)
+
+    os.makedirs(build_dir, exist_ok=True)
+    command = [compiler, '-std=c++14', '-O2', '-DNDEBUG'] + config['flags'] + sources + ['-o', binary]
+    print('Building {}: {}'.format(lab, ' '.join(command)), file=sys.stderr)
+    subprocess.run(command, check=True)
+
+    return binary
+
+
+def command_line(lab, binary, size, output, args):
+    if lab == 'lab02':
+        # The input file is ignored with generated matrices but still expected positionally
+        return [binary, 'generated', str(args.precision), str(args.max_iterations), '-g', str(size), '-o', output]
+    return [binary, 'generated', '-g', str(size), '-o', output]
+
+
+def parse(lab, stdout):
+    """Returns (total time in ms, solve time in ms, iterations) of one run."""
+    if lab == 'lab02':
+        total = LAB02_TIME.search(stdout)
+        # With -compare or -cold the last solver line is the one of the requested solver
+        solvers = LAB02_SOLVER.findall(stdout)
+        if total is None or not solvers:
+            raise RuntimeError('Unexpected Lab02 output:\n' + stdout)
+        iterations, solve = solvers[-1]
+        return float(total.group(1)), float(solve), int(iterations)
+
+    total = LAB03_TIME.search(stdout)
+    if total is None:
+        raise RuntimeError('Unexpected Lab03 output:\n' + stdout)
+    seconds, millis, micros = (int(value) for value in total.groups())
+    time = seconds * 1000.0 + millis + micros / 1000.0
+    return time, time, ''
+
+
+def verify_sorted(path):
+    with open(path) as f:
+        values = [int(value) for value in f.read().split()]
+    return all(a <= b for a, b in zip(values, values[1:]))
+
+
+def run(lab, binary, np, size, args, work_dir):
+    output = os.path.join(work_dir, '{}_{}_{}.txt'.format(lab, np, size))
+    extra = args.args.split() if args.args is not None else LABS[lab]['default_args']
+    command = [args.mpirun, '-np', str(np)] + args.mpi_args.split() + command_line(lab, binary, size, output, args) + extra
+
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    if result.returncode != 0 or 'Error occurred' in result.stderr:
+        raise RuntimeError('{} failed:\n{}{}'.format(' '.join(command), result.stdout, result.stderr))
+
+    if lab == 'lab03' and args.verify and not verify_sorted(output):
+        raise RuntimeError('{} produced unsorted output in {}'.format(' '.join(command), output))
+
+    return parse(lab, result.stdout)
+
+
+def sweep(lab, binary, args, work_dir, writer):
+    processes = sorted(set(args.np))
+    baselines = {}
+
+    for base_size in args.sizes:
+        for np in processes:
+            size = LABS[lab]['weak_size'](base_size, np) if args.mode == 'weak' else base_size
+            runs = [run(lab, binary, np, size, args, work_dir) for _ in range(args.trials)]
+
+            times = [r[0] if args.metric == 'total' else r[1] for r in runs]
+            median = statistics.median(times)
+
+            # Strong: speedup = T1 / Tp, efficiency = speedup / p.
+            # Weak: efficiency = T1 / Tp on p times the work, speedup is the scaled one p * efficiency.
+            if np == 1:
+                baselines[base_size] = median
+            baseline = baselines.get(base_size)
+            if baseline is None or median == 0:
+                speedup = efficiency = ''
+            elif args.mode == 'strong':
+                speedup = baseline / median
+                efficiency = speedup / np
+            else:
+                efficiency = baseline / median
+                speedup = efficiency * np
+
+            row = {
+                'lab': lab,
+                'mode': args.mode,
+                'np': np,
+                'size': size,
+                'trials': args.trials,
+                'metric': args.metric,
+                'min_ms': min(times),
+                'median_ms': median,
+                'mean_ms': statistics.mean(times),
+                'max_ms': max(times),
+                'stdev_ms': statistics.stdev(times) if len(times) > 1 else 0.0,
+                'speedup': speedup,
+                'efficiency': efficiency,
+                'iterations': runs[-1][2],
+                'times_ms': ';'.join('{:.3f}'.format(t) for t in times),
+            }
+            writer.writerow(row)
+            print('{lab} {mode} np={np} size={size}: median {median_ms:.3f}ms, speedup {speedup}, '
+                  'efficiency {efficiency}'.format(**row), file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Local strong/weak scaling benchmark of the MPI labs')
+    parser.add_argument('labs', nargs='+', choices=sorted(LABS))
+    parser.add_argument('--mode', choices=['strong', 'weak'], default='strong')
+    parser.add_argument('--np', type=int, nargs='+', default=[1, 2, 4],
+                        help='process counts; 1 is always added as the baseline')
+    parser.add_argument('--sizes', type=int, nargs='+', required=True,
+                        help='problem sizes; for the weak mode the size of the 1-process run')
+    parser.add_argument('--trials', type=int, default=5)
+    parser.add_argument('--metric', choices=['total', 'solve'], default='total',
+                        help='Lab02 only: whole run or the solver alone')
+    parser.add_argument('--csv', default='benchmark.csv')
+    parser.add_argument('--build-dir', default=os.path.join(ROOT, '_bench'))
+    parser.add_argument('--binary', help='use this executable instead of building one (single lab only)')
+    parser.add_argument('--compiler', default='mpicxx')
+    parser.add_argument('--mpirun', default='mpirun')
+    parser.add_argument('--mpi-args', default='', help='extra launcher arguments, e.g. --oversubscribe')
+    parser.add_argument('--args', help='extra program arguments instead of the lab defaults')
+    parser.add_argument('--precision', type=float, default=1e-10)
+    parser.add_argument('--max-iterations', type=int, default=100000)
+    parser.add_argument('--verify', action='store_true', help='Lab03 only: check every output is sorted')
+    args = parser.parse_args()
+
+    if 1 not in args.np:
+        args.np.append(1)
+    if args.binary and len(args.labs) > 1:
+        parser.error('--binary can be used with a single lab only')
+
+    fields = ['lab', 'mode', 'np', 'size', 'trials', 'metric', 'min_ms', 'median_ms', 'mean_ms', 'max_ms',
+              'stdev_ms', 'speedup', 'efficiency', 'iterations', 'times_ms']
+
+    os.makedirs(args.build_dir, exist_ok=True)
+
+    with open(args.csv, 'w', newline='') as f:
+        writer = csv.DictWriter(f, fieldnames=fields)
+        writer.writeheader()
+
+        for lab in args.labs:
+            binary = args.binary or build(lab, args.build_dir, args.compiler)
+            sweep(lab, binary, args, args.build_dir, writer)
+            f.flush()
+
+
+if __name__ == '__main__':
+    main()